@@ -212,7 +212,7 @@ public:
       *cmd++ = {
         .count         = meshData.meshes[i].getLODIndicesCount(0),
         .instanceCount = 1,
-        .firstIndex    = meshData.meshes[i].indexOffset,
+        .firstIndex    = (uint32_t)meshData.meshes[i].indexOffset,
         .baseVertex    = (int32_t)meshData.meshes[i].vertexOffset,
         .baseInstance  = 0,
       };
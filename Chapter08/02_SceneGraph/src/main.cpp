@@ -195,9 +195,11 @@ int main()
     MeshData meshData;
     Scene ourScene;
 
-    loadMeshFile("data/meshes/orrery/scene.gltf", meshData, ourScene, true);
+    // geometry is streamed directly into the cache file
+    MeshDataWriter writer(fileNameCachedMeshes);
+    loadMeshFile("data/meshes/orrery/scene.gltf", writer, meshData, ourScene, true);
+    writer.close();
 
-    saveMeshData(fileNameCachedMeshes, meshData);
     saveMeshDataMaterials(fileNameCachedMaterials, meshData);
     saveScene(fileNameCachedHierarchy, ourScene);
   }
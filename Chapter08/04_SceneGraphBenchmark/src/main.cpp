@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+#include "shared/Scene/Scene.h"
+#include "shared/Scene/VtxData.h"
+#include "shared/UtilsMath.h"
+
+#include <taskflow/taskflow.hpp>
+
+// 1M-node synthetic scenes: the root has numNodes/depth chains of 'depth' nodes
+static void createScene(Scene& scene, uint32_t numNodes, uint32_t depth)
+{
+  scene = Scene();
+
+  scene.hierarchy.reserve(numNodes);
+  scene.localTransform.reserve(numNodes);
+  scene.globalTransform.reserve(numNodes);
+
+  addNode(scene, -1, 0);
+
+  for (uint32_t i = 1; i != numNodes; i++) {
+    const int level = int((i - 1) % depth) + 1;
+    const int node  = addNode(scene, level == 1 ? 0 : int(i - 1), level);
+
+    scene.localTransform[node] = glm::rotate(glm::translate(mat4(1.0f), vec3(1.0f, 0.0f, 0.0f)), 0.001f, vec3(0.0f, 1.0f, 0.0f));
+  }
+}
+
+template <typename F> static double measureMs(int numRuns, F&& func)
+{
+  double best = 1e30;
+  for (int i = 0; i != numRuns; i++) {
+    const auto start = std::chrono::high_resolution_clock::now();
+    func();
+    best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+  }
+  return best;
+}
+
+// the generic glm path replaced by transformBoxAffine(): 8 transformed corners
+static BoundingBox transformBoxCorners(const BoundingBox& b, const mat4& t)
+{
+  const vec3 corners[] = {
+    vec3(t * vec4(b.min_.x, b.min_.y, b.min_.z, 1.0f)), vec3(t * vec4(b.min_.x, b.max_.y, b.min_.z, 1.0f)),
+    vec3(t * vec4(b.min_.x, b.min_.y, b.max_.z, 1.0f)), vec3(t * vec4(b.min_.x, b.max_.y, b.max_.z, 1.0f)),
+    vec3(t * vec4(b.max_.x, b.min_.y, b.min_.z, 1.0f)), vec3(t * vec4(b.max_.x, b.max_.y, b.min_.z, 1.0f)),
+    vec3(t * vec4(b.max_.x, b.min_.y, b.max_.z, 1.0f)), vec3(t * vec4(b.max_.x, b.max_.y, b.max_.z, 1.0f)),
+  };
+  return BoundingBox(corners, 8);
+}
+
+// 1M boxes and transforms: the glm paths against the affine kernels (see UtilsMathSIMD.h)
+static void benchmarkAffineKernels(uint32_t count, int numRuns)
+{
+  std::vector<BoundingBox> boxes(count);
+  std::vector<BoundingBox> outBoxes(count);
+  std::vector<mat4> transforms(count);
+  std::vector<mat4> outTransforms(count);
+
+  srand(0);
+  for (uint32_t i = 0; i != count; i++) {
+    const mat4 t  = glm::rotate(glm::translate(mat4(1.0f), randVec()), randomFloat(0.0f, Math::TWOPI), vec3(0, 1, 0));
+    boxes[i]      = BoundingBox(randVec(), randVec());
+    transforms[i] = glm::scale(t, randVec());
+  }
+
+  const double msBoxesGLM = measureMs(numRuns, [&]() {
+    for (uint32_t i = 0; i != count; i++)
+      outBoxes[i] = transformBoxCorners(boxes[i], transforms[i]);
+  });
+  const double msBoxesAffine = measureMs(numRuns, [&]() {
+    for (uint32_t i = 0; i != count; i++)
+      outBoxes[i] = boxes[i].getTransformed(transforms[i]);
+  });
+  const double msMatGLM = measureMs(numRuns, [&]() {
+    for (uint32_t i = 0; i != count; i++)
+      outTransforms[i] = transforms[count - 1 - i] * transforms[i];
+  });
+  const double msMatAffine = measureMs(numRuns, [&]() {
+    for (uint32_t i = 0; i != count; i++)
+      multiplyAffine(transforms[count - 1 - i], transforms[i], outTransforms[i]);
+  });
+
+#if defined(UTILS_SIMD_SSE)
+  const char* kernels = "SSE2";
+#elif defined(UTILS_SIMD_NEON)
+  const char* kernels = "NEON";
+#else
+  const char* kernels = "scalar";
+#endif
+
+  printf("glm %d.%d.%d against the %s affine kernels:\n", GLM_VERSION_MAJOR, GLM_VERSION_MINOR, GLM_VERSION_PATCH, kernels);
+  printf(
+      "%u boxes:      glm (8 corners) %7.2f ms, transformBoxAffine() %7.2f ms (%4.2fx)\n", count, msBoxesGLM, msBoxesAffine,
+      msBoxesGLM / msBoxesAffine);
+  printf(
+      "%u transforms: glm (mat4 * mat4) %5.2f ms, multiplyAffine()     %7.2f ms (%4.2fx)\n\n", count, msMatGLM, msMatAffine,
+      msMatGLM / msMatAffine);
+}
+
+// the serial merge replaced by mergeMeshData(): containers appended one by one, indices shifted by the vertex base one by one
+static void mergeMeshDataSerial(MeshData& m, const std::vector<MeshData*>& md)
+{
+  m.streams = md[0]->streams;
+
+  const uint32_t vertexSize = m.streams.getVertexSize();
+
+  uint32_t numVertices = 0;
+  uint32_t numIndices  = 0;
+  uint32_t numMeshes   = 0;
+  uint32_t numMtls     = 0;
+
+  for (const MeshData* d : md) {
+    mergeVectors(m.indexData, d->indexData);
+    mergeVectors(m.vertexData, d->vertexData);
+    mergeVectors(m.meshes, d->meshes);
+    mergeVectors(m.boxes, d->boxes);
+
+    for (size_t j = 0; j != d->meshes.size(); j++) {
+      m.meshes[numMeshes + j].indexOffset += numIndices;
+      m.meshes[numMeshes + j].materialID += numMtls;
+    }
+    for (size_t j = 0; j != d->indexData.size(); j++)
+      m.indexData[numIndices + j] += numVertices;
+
+    numMeshes += (uint32_t)d->meshes.size();
+    numMtls += (uint32_t)d->materials.size();
+    numIndices += (uint32_t)d->indexData.size();
+    numVertices += (uint32_t)d->vertexData.size() / vertexSize;
+  }
+}
+
+// 'count' containers of 16 meshes each (10K vertices and 30K indices per mesh): the serial merge against mergeMeshData()
+static void benchmarkMergeMeshData(uint32_t count, int numRuns)
+{
+  const uint32_t kMeshesPerContainer = 16;
+  const uint32_t kVerticesPerMesh    = 10000;
+  const uint32_t kIndicesPerMesh     = 30000;
+
+  std::vector<MeshData> containers(count);
+  std::vector<MeshData*> ptrs;
+
+  srand(0);
+  for (MeshData& d : containers) {
+    d.streams = {
+      .attributes    = { { .location = 0, .format = lvk::VertexFormat_Float3, .offset = 0 } },
+      .inputBindings = { { .stride = sizeof(vec3) } },
+    };
+    for (uint32_t i = 0; i != kMeshesPerContainer; i++) {
+      Mesh mesh;
+      mesh.indexOffset  = d.indexData.size();
+      mesh.vertexOffset = d.vertexData.size() / sizeof(vec3);
+      mesh.vertexCount  = kVerticesPerMesh;
+      mesh.lodOffset[1] = kIndicesPerMesh;
+      for (uint32_t j = 0; j != kIndicesPerMesh; j++)
+        d.indexData.push_back(rand() % kVerticesPerMesh);
+      d.vertexData.resize(d.vertexData.size() + kVerticesPerMesh * sizeof(vec3), uint8_t(i));
+      d.meshes.push_back(mesh);
+      d.boxes.emplace_back(vec3(0.0f), vec3(1.0f));
+    }
+    ptrs.push_back(&d);
+  }
+
+  const double msSerial = measureMs(numRuns, [&ptrs]() {
+    MeshData m;
+    mergeMeshDataSerial(m, ptrs);
+  });
+  const double msMerge = measureMs(numRuns, [&ptrs]() {
+    MeshData m;
+    mergeMeshData(m, ptrs);
+  });
+
+  const uint64_t numBytes = uint64_t(count) * kMeshesPerContainer * (kIndicesPerMesh * sizeof(uint32_t) + kVerticesPerMesh * sizeof(vec3));
+
+  printf(
+      "%u containers (%.0f MB): serial merge %7.2f ms, mergeMeshData() %7.2f ms\n\n", count, double(numBytes) / (1024.0 * 1024.0),
+      msSerial, msMerge);
+}
+
+int main()
+{
+  const uint32_t kNumNodes = 1024 * 1024;
+  const int kNumRuns       = 5;
+
+  const uint32_t kNumThreads[] = { 1, 2, 4, 8, 16 };
+
+  std::vector<std::unique_ptr<tf::Executor>> executors;
+  for (uint32_t n : kNumThreads)
+    executors.push_back(std::make_unique<tf::Executor>(n));
+
+  benchmarkAffineKernels(kNumNodes, kNumRuns);
+  benchmarkMergeMeshData(64, kNumRuns);
+
+  // the scaling curve: each N-thread column is the time of the parallel update and its speedup over the serial one
+  printf(
+      "Update of all the nodes (ms) and of 1%% random dirty nodes (ms), serial and with N threads (%u hardware threads):\n",
+      std::thread::hardware_concurrency());
+  printf("%8s %10s", "depth", "serial");
+  for (uint32_t n : kNumThreads)
+    printf(" %14u thr", n);
+  printf(" %10s\n", "1% dirty");
+
+  // the last one is a single chain of all the nodes
+  for (uint32_t depth : { 1u, 4u, 16u, 64u, 256u, 1024u, 16384u, kNumNodes - 1 }) {
+    Scene scene;
+    createScene(scene, kNumNodes, depth);
+
+    // everything is dirty: mark the root
+    const double msAll = measureMs(kNumRuns, [&scene]() {
+      markAsChanged(scene, 0);
+      recalculateGlobalTransforms(scene);
+    });
+
+    printf("%8u %10.2f", depth, msAll);
+
+    for (const std::unique_ptr<tf::Executor>& executor : executors) {
+      const double msThreads = measureMs(kNumRuns, [&scene, &executor]() {
+        markAsChanged(scene, 0);
+        recalculateGlobalTransforms(scene, *executor);
+      });
+      printf(" %10.2f (%4.2fx)", msThreads, msAll / msThreads);
+    }
+
+    // random nodes, marked in no particular order
+    std::vector<int> dirty(kNumNodes / 100);
+    srand(depth);
+    for (int& n : dirty)
+      n = 1 + rand() % (kNumNodes - 1);
+
+    const double msDirty = measureMs(kNumRuns, [&scene, &dirty]() {
+      for (int n : dirty)
+        markAsChanged(scene, n);
+      recalculateGlobalTransforms(scene);
+    });
+
+    printf(" %10.2f\n", msDirty);
+  }
+
+  return 0;
+}
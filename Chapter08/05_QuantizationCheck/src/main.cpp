@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "shared/Scene/VtxData.h"
+#include "shared/UtilsMath.h"
+
+// Headless round-trip check of the quantized vertex layout (see convertAIMesh()): positions of synthetic boxes go through
+// quantizePosition()/dequantizePosition() and have to stay within getPositionQuantizationBound(), unit normals go through
+// encodeOctahedralNormal()/decodeOctahedralNormal() and have to stay within kMaxNormalError.
+
+// SNORM16 octahedral coordinates are rounded to 1/32767, which moves a unit vector by less than 1e-4
+const float kMaxNormalError = 1e-4f;
+
+uint32_t numChecks   = 0;
+uint32_t numFailures = 0;
+
+static void check(bool condition, const char* what, const vec3& v, float error, float bound)
+{
+  numChecks++;
+
+  if (condition)
+    return;
+
+  if (numFailures++ < 20)
+    printf("FAILED: %s (%g, %g, %g): error %g, bound %g\n", what, v.x, v.y, v.z, error, bound);
+}
+
+static float checkPosition(const vec3& p, const BoundingBox& box)
+{
+  uint16_t q[4];
+  quantizePosition(p, box, q);
+
+  const vec3 d      = glm::abs(dequantizePosition(q, box) - p);
+  const float error = std::max(d.x, std::max(d.y, d.z));
+  const float bound = getPositionQuantizationBound(box);
+
+  check(q[3] == 0, "the 4th component is zero", p, 0.0f, 0.0f);
+  check(error <= bound, "position within the bound", p, error, bound);
+
+  return bound > 0.0f ? error / bound : 0.0f;
+}
+
+static float checkNormal(const vec3& n)
+{
+  const vec3 decoded = decodeOctahedralNormal(encodeOctahedralNormal(n));
+  const float error  = glm::length(decoded - n);
+
+  check(fabsf(glm::length(decoded) - 1.0f) <= 1e-6f, "decoded normal has unit length", n, glm::length(decoded), 1.0f);
+  check(error <= kMaxNormalError, "normal within the bound", n, error, kMaxNormalError);
+
+  return error;
+}
+
+int main()
+{
+  srand(0);
+
+  // boxes from millimeters to kilometers, around the origin and far away from it (the Bistro is in centimeters), including
+  // flat and degenerate ones
+  const float kCenters[] = { 0.0f, 1.0f, -250.0f, 1e4f, -1e5f };
+  const float kSizes[]   = { 1e-3f, 0.1f, 1.0f, 37.5f, 2000.0f, 1e5f };
+
+  const uint32_t kNumRandomPoints = 2000;
+  const uint32_t kGridSize        = 9;
+
+  uint32_t numBoxes       = 0;
+  float maxPositionsRatio = 0.0f; // largest error relative to the bound
+
+  for (float center : kCenters) {
+    for (float size : kSizes) {
+      const vec3 extents[] = {
+        vec3(size),                            // cube
+        vec3(size, 0.01f * size, 3.0f * size), // non-uniform
+        vec3(size, 0.0f, size),                // flat
+        vec3(0.0f),                            // a single point
+      };
+      for (const vec3& extent : extents) {
+        const vec3 c = vec3(center, -0.5f * center, 0.25f * center);
+        const BoundingBox box(c - 0.5f * extent, c + 0.5f * extent);
+        numBoxes++;
+
+        // the corners and a regular grid, which includes the faces of the box...
+        for (uint32_t x = 0; x != kGridSize; x++) {
+          for (uint32_t y = 0; y != kGridSize; y++) {
+            for (uint32_t z = 0; z != kGridSize; z++) {
+              const vec3 t      = vec3(float(x), float(y), float(z)) / float(kGridSize - 1);
+              const vec3 p      = box.min_ + t * box.getSize();
+              maxPositionsRatio = std::max(maxPositionsRatio, checkPosition(glm::clamp(p, box.min_, box.max_), box));
+            }
+          }
+        }
+
+        // ...and random points inside
+        for (uint32_t i = 0; i != kNumRandomPoints; i++)
+          maxPositionsRatio = std::max(maxPositionsRatio, checkPosition(randomVec(box.min_, box.max_), box));
+      }
+    }
+  }
+
+  printf("%u boxes: largest position error is %.3f of the bound\n", numBoxes, maxPositionsRatio);
+
+  // normals on a latitude/longitude grid, which crosses the octahedron edges (x = 0, y = 0, z = 0) and hits the poles...
+  const uint32_t kNumLatitudes  = 360;
+  const uint32_t kNumLongitudes = 720;
+
+  float maxNormalError = 0.0f;
+
+  for (uint32_t i = 0; i <= kNumLatitudes; i++) {
+    const float theta = Math::PI * float(i) / float(kNumLatitudes);
+    for (uint32_t j = 0; j != kNumLongitudes; j++) {
+      const float phi = Math::TWOPI * float(j) / float(kNumLongitudes);
+      const vec3 n    = vec3(sinf(theta) * cosf(phi), sinf(theta) * sinf(phi), cosf(theta));
+      maxNormalError  = std::max(maxNormalError, checkNormal(glm::normalize(n)));
+    }
+  }
+
+  // ...and random directions
+  for (uint32_t i = 0; i != 100000; i++) {
+    const vec3 n = randomVec(vec3(-1.0f), vec3(1.0f));
+    if (glm::length(n) > 1e-3f)
+      maxNormalError = std::max(maxNormalError, checkNormal(glm::normalize(n)));
+  }
+
+  printf("Normals: largest error is %g (bound %g)\n", maxNormalError, kMaxNormalError);
+
+  printf("\n%u checks, %u failed\n", numChecks, numFailures);
+
+  return numFailures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <execution>
 #include <filesystem>
+#include <thread>
 
 #include <ktx.h>
 #include <ktx-software/lib/src/gl_format.h>
@@ -13,7 +14,11 @@
 #include "stb_image.h"
 #include "stb_image_resize2.h"
 
+#include <taskflow/taskflow.hpp>
+
 #include "shared/UtilsGLTF.h"
+#include "shared/Scene/MergeUtil.h"
+#include "shared/Scene/MeshStats.h"
 #include "Chapter08/VKMesh08.h"
 
 // these macros can be redefined externally
@@ -22,6 +27,11 @@
 #define DEMO_TEXTURE_CACHE_FOLDER ".cache/out_textures/"
 #endif
 
+#if !defined(DEMO_MESH_CACHE_FOLDER)
+// converted meshes are cached here, keyed by the hash of their source geometry (see convertAIMeshCached())
+#define DEMO_MESH_CACHE_FOLDER ".cache/out_meshes/"
+#endif
+
 // find a file in directory which "almost" coincides with the origFile (their lowercase versions coincide)
 std::string findSubstitute(const std::string& origFile)
 {
@@ -48,9 +58,10 @@ std::string fixTextureFile(const std::string& file)
   return std::filesystem::exists(file) ? file : findSubstitute(file);
 }
 
+// 'reuseExisting' skips the conversion if the output file already exists (the caller knows the source images have not changed)
 std::string convertTexture(
     const std::string& file, const std::string& basePath, std::unordered_map<std::string, uint32_t>& opacityMapIndices,
-    const std::vector<std::string>& opacityMaps)
+    const std::vector<std::string>& opacityMaps, bool reuseExisting = false)
 {
   const int maxNewWidth  = DEMO_TEXTURE_MAX_SIZE;
   const int maxNewHeight = DEMO_TEXTURE_MAX_SIZE;
@@ -66,6 +77,9 @@ std::string convertTexture(
                               lowercaseString(replaceAll(replaceAll(srcFile, "..", "__"), "/", "__") + std::string("__rescaled")) +
                               std::string(".ktx");
 
+  if (reuseExisting && fs::exists(newFile))
+    return newFile;
+
   // load this image
   int origWidth, origHeight, texChannels;
   stbi_uc* pixels = stbi_load(fixTextureFile(srcFile).c_str(), &origWidth, &origHeight, &texChannels, STBI_rgb_alpha);
@@ -189,7 +203,7 @@ std::string convertTexture(
 
 void convertAndDownscaleAllTextures(
     const std::vector<Material>& materials, const std::string& basePath, std::vector<std::string>& files,
-    std::vector<std::string>& opacityMaps)
+    std::vector<std::string>& opacityMaps, bool reuseConvertedTextures = false)
 {
   std::unordered_map<std::string, uint32_t> opacityMapIndices(files.size());
 
@@ -198,7 +212,7 @@ void convertAndDownscaleAllTextures(
       opacityMapIndices[files[m.baseColorTexture]] = (uint32_t)m.opacityTexture;
 
   auto converter = [&](const std::string& s) -> std::string {
-    return convertTexture(s, basePath, opacityMapIndices, opacityMaps);
+    return convertTexture(s, basePath, opacityMapIndices, opacityMaps, reuseConvertedTextures);
   };
 
 #if defined(__cpp_lib_execution)
@@ -257,7 +271,113 @@ void traverse(const aiScene* sourceScene, Scene& scene, aiNode* N, int parent, i
     traverse(sourceScene, scene, N->mChildren[n], newNode, depth + 1);
 }
 
-void loadMeshFile(const char* fileName, MeshData& meshData, Scene& ourScene, bool generateLODs)
+// Content hash of everything convertAIMesh() reads from 'm' plus the conversion parameters. The material index is not
+// included: it is patched after a cache hit, so reassigning materials does not invalidate converted geometry.
+uint64_t getAIMeshHash(const aiMesh* m, bool generateLODs, bool quantize)
+{
+  const uint32_t params[] = {
+    kConvertAIMeshVersion, generateLODs ? 1u : 0u, quantize ? 1u : 0u, m->mNumVertices, m->HasTextureCoords(0) ? 1u : 0u,
+  };
+
+  uint64_t hash = hash64(params, sizeof(params));
+
+  hash = hash64(m->mVertices, sizeof(aiVector3D) * m->mNumVertices, hash);
+  hash = hash64(m->mNormals, sizeof(aiVector3D) * m->mNumVertices, hash);
+  if (m->HasTextureCoords(0))
+    hash = hash64(m->mTextureCoords[0], sizeof(aiVector3D) * m->mNumVertices, hash);
+
+  std::vector<uint32_t> indices;
+  indices.reserve(m->mNumFaces * 3);
+  for (unsigned int i = 0; i != m->mNumFaces; i++) {
+    if (m->mFaces[i].mNumIndices != 3)
+      continue;
+    indices.insert(indices.end(), m->mFaces[i].mIndices, m->mFaces[i].mIndices + 3);
+  }
+
+  return hash64(indices.data(), indices.size() * sizeof(uint32_t), hash);
+}
+
+// exact comparison of everything getAIMeshHash() hashes (guards geometry deduplication against hash collisions)
+bool isSameAIMeshGeometry(const aiMesh* a, const aiMesh* b)
+{
+  if (a->mNumVertices != b->mNumVertices || a->mNumFaces != b->mNumFaces || a->HasTextureCoords(0) != b->HasTextureCoords(0))
+    return false;
+
+  const size_t size = sizeof(aiVector3D) * a->mNumVertices;
+
+  if (memcmp(a->mVertices, b->mVertices, size) || memcmp(a->mNormals, b->mNormals, size))
+    return false;
+  if (a->HasTextureCoords(0) && memcmp(a->mTextureCoords[0], b->mTextureCoords[0], size))
+    return false;
+
+  for (unsigned int i = 0; i != a->mNumFaces; i++) {
+    const aiFace& fa = a->mFaces[i];
+    const aiFace& fb = b->mFaces[i];
+    if (fa.mNumIndices != fb.mNumIndices || memcmp(fa.mIndices, fb.mIndices, sizeof(unsigned int) * fa.mNumIndices))
+      return false;
+  }
+
+  return true;
+}
+
+struct MeshCacheStats {
+  uint32_t hits   = 0;
+  uint32_t misses = 0;
+  std::string lodLog; // LOD summary of the meshes converted on a cache miss (see processLODs())
+};
+
+// Convert a single aiMesh into 'out' (which must be empty), reusing the result of an earlier conversion of identical
+// geometry if there is one. Each cache entry is a .meshes file with one mesh; the content hash is stored as its sources
+// stamp, so entries are verified like any other cache file and corrupted ones are simply reconverted.
+// 'hash' is getAIMeshHash(m, generateLODs, quantize)
+void convertAIMeshCached(const aiMesh* m, uint64_t hash, MeshData& out, bool generateLODs, bool quantize, MeshCacheStats& stats)
+{
+  namespace fs = std::filesystem;
+
+  char fileName[256];
+  snprintf(fileName, sizeof(fileName), "%s%016llx.meshes", DEMO_MESH_CACHE_FOLDER, (unsigned long long)hash);
+
+  if (isMeshDataValid(fileName, hash, true)) {
+    loadMeshData(fileName, out);
+    if (out.meshes.size() == 1) {
+      out.meshes[0].materialID = m->mMaterialIndex;
+      stats.hits++;
+      return;
+    }
+    out = MeshData();
+  }
+
+  stats.misses++;
+
+  uint32_t indexOffset  = 0;
+  uint32_t vertexOffset = 0;
+  out.meshes.push_back(convertAIMesh(m, out, indexOffset, vertexOffset, generateLODs, quantize, &stats.lodLog));
+
+  if (!fs::exists(DEMO_MESH_CACHE_FOLDER)) {
+    fs::create_directories(DEMO_MESH_CACHE_FOLDER);
+  }
+
+  // meshes are converted in parallel and the same geometry can be converted twice (with different materials): write a private
+  // file and rename it, so no one ever sees a partially written entry
+  const std::string tmpFileName =
+      std::string(fileName) + "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+
+  saveMeshData(tmpFileName.c_str(), out, false, hash);
+
+  std::error_code ec;
+  fs::rename(tmpFileName, fileName, ec);
+  if (ec) {
+    // an identical entry is already there (and may be in use)
+    fs::remove(tmpFileName, ec);
+  }
+}
+
+// if 'writer' is not null, converted geometry is appended to it one batch of meshes at a time instead of being kept in 'meshData'
+// 'reuseConvertedTextures' keeps already converted .ktx files (see convertTexture())
+// 'quantizeVertices' selects the quantized vertex layout (see convertAIMesh())
+void convertMeshFile(
+    const char* fileName, MeshData& meshData, Scene& ourScene, bool generateLODs, MeshDataWriter* writer, bool reuseConvertedTextures,
+    bool quantizeVertices)
 {
   printf("Loading '%s'...\n", fileName);
 
@@ -276,15 +396,126 @@ void loadMeshFile(const char* fileName, MeshData& meshData, Scene& ourScene, boo
   meshData.meshes.reserve(scene->mNumMeshes);
   meshData.boxes.reserve(scene->mNumMeshes);
 
-  uint32_t indexOffset  = 0;
-  uint32_t vertexOffset = 0;
+  // content hashes of all meshes are computed in parallel...
+  std::vector<uint64_t> hashes(scene->mNumMeshes);
+  {
+    tf::Taskflow taskflow;
+    taskflow.for_each_index(0u, scene->mNumMeshes, 1u, [&](uint32_t i) {
+      hashes[i] = getAIMeshHash(scene->mMeshes[i], generateLODs, quantizeVertices);
+    });
+    runTaskflow(taskflow);
+  }
+
+  // ...and deduplicated in order: identical geometry with the same material is converted once, all scene nodes referencing any
+  // of its copies share one Mesh
+  std::vector<uint32_t> meshRemap(scene->mNumMeshes); // aiMesh -> Mesh
+  std::vector<uint32_t> uniqueAIMeshes;               // Mesh -> first aiMesh converted into it
+  std::vector<uint32_t> numCopies;                    // Mesh -> number of aiMeshes sharing it
+  std::unordered_map<uint64_t, uint32_t> meshForHash; // content hash (with material) -> Mesh
 
   for (unsigned int i = 0; i != scene->mNumMeshes; i++) {
-    printf("\rConverting meshes %u/%u...", i + 1, scene->mNumMeshes);
+    const aiMesh* m        = scene->mMeshes[i];
+    const uint64_t key     = hash64(&m->mMaterialIndex, sizeof(m->mMaterialIndex), hashes[i]);
+    const auto [it, isNew] = meshForHash.try_emplace(key, (uint32_t)uniqueAIMeshes.size());
+    if (!isNew && isSameAIMeshGeometry(scene->mMeshes[uniqueAIMeshes[it->second]], m)) {
+      meshRemap[i] = it->second;
+      numCopies[it->second]++;
+      continue;
+    }
+    meshRemap[i] = (uint32_t)uniqueAIMeshes.size();
+    uniqueAIMeshes.push_back(i);
+    numCopies.push_back(1);
+  }
+
+  if (!std::filesystem::exists(DEMO_MESH_CACHE_FOLDER)) {
+    std::filesystem::create_directories(DEMO_MESH_CACHE_FOLDER);
+  }
+
+  // Unique meshes are converted in parallel, in batches, each one into its own MeshData. The results are then appended in order,
+  // so the output is identical to a serial conversion and the memory used by the streaming path ('writer') stays bounded.
+  const uint32_t numUniqueMeshes = (uint32_t)uniqueAIMeshes.size();
+  const uint32_t batchSize       = std::max(4u * (uint32_t)getSharedExecutor().num_workers(), 1u);
+
+  std::vector<MeshData> converted(std::min(batchSize, numUniqueMeshes));
+  std::vector<MeshCacheStats> convertedStats(converted.size());
+  std::vector<uint64_t> indexOffsets(converted.size());
+  std::vector<uint64_t> vertexOffsets(converted.size());
+
+  MeshCacheStats cacheStats;
+  uint64_t savedBytes = 0;
+
+  for (uint32_t first = 0; first < numUniqueMeshes; first += batchSize) {
+    const uint32_t count = std::min(batchSize, numUniqueMeshes - first);
+
+    printf("\rConverting meshes %u/%u...", first + count, numUniqueMeshes);
     fflush(stdout);
-    meshData.meshes.push_back(convertAIMesh(scene->mMeshes[i], meshData, indexOffset, vertexOffset, generateLODs));
+
+    {
+      tf::Taskflow taskflow;
+      taskflow.for_each_index(0u, count, 1u, [&](uint32_t i) {
+        const uint32_t id = uniqueAIMeshes[first + i];
+        converted[i]      = MeshData();
+        convertedStats[i] = MeshCacheStats();
+        convertAIMeshCached(scene->mMeshes[id], hashes[id], converted[i], generateLODs, quantizeVertices, convertedStats[i]);
+      });
+      runTaskflow(taskflow);
+    }
+
+    for (uint32_t i = 0; i != count; i++) {
+      const MeshData& mesh = converted[i];
+      printf("%s", convertedStats[i].lodLog.c_str());
+      cacheStats.hits += convertedStats[i].hits;
+      cacheStats.misses += convertedStats[i].misses;
+      savedBytes += (numCopies[first + i] - 1) * (mesh.indexData.size() * sizeof(uint32_t) + mesh.vertexData.size());
+      meshData.streams = mesh.streams;
+    }
+
+    if (writer) {
+      for (uint32_t i = 0; i != count; i++) {
+        writer->addMeshData(converted[i]);
+      }
+      continue;
+    }
+
+    // prefix sums of the index and vertex counts place the meshes of this batch after the ones already in 'meshData'
+    const uint32_t vertexSize = meshData.streams.getVertexSize();
+
+    uint64_t numIndices  = meshData.indexData.size();
+    uint64_t numVertices = meshData.vertexData.size() / vertexSize;
+
+    for (uint32_t i = 0; i != count; i++) {
+      indexOffsets[i]  = numIndices;
+      vertexOffsets[i] = numVertices;
+      numIndices += converted[i].indexData.size();
+      numVertices += converted[i].vertexData.size() / vertexSize;
+
+      Mesh result         = converted[i].meshes[0];
+      result.indexOffset  = indexOffsets[i];
+      result.vertexOffset = vertexOffsets[i];
+      meshData.meshes.push_back(result);
+      meshData.boxes.push_back(converted[i].boxes[0]);
+    }
+
+    meshData.indexData.resize(numIndices);
+    meshData.vertexData.resize(numVertices * vertexSize);
+
+    {
+      tf::Taskflow taskflow;
+      taskflow.for_each_index(0u, count, 1u, [&](uint32_t i) {
+        const MeshData& mesh = converted[i];
+        std::copy(mesh.indexData.begin(), mesh.indexData.end(), meshData.indexData.begin() + indexOffsets[i]);
+        std::copy(mesh.vertexData.begin(), mesh.vertexData.end(), meshData.vertexData.begin() + vertexOffsets[i] * vertexSize);
+      });
+      runTaskflow(taskflow);
+    }
   }
   printf("\n");
+  printf(
+      "Mesh cache: %u hits, %u misses (%.1f%% hit rate)\n", cacheStats.hits, cacheStats.misses,
+      numUniqueMeshes ? 100.0 * cacheStats.hits / numUniqueMeshes : 0.0);
+  printf(
+      "Geometry deduplication: %u unique meshes out of %u, %.2f MB saved\n", numUniqueMeshes, scene->mNumMeshes,
+      double(savedBytes) / (1024.0 * 1024.0));
 
   // extract base model path
   const std::size_t pathSeparator = std::string(fileName).find_last_of("/\\");
@@ -301,10 +532,123 @@ void loadMeshFile(const char* fileName, MeshData& meshData, Scene& ourScene, boo
   printf("\n");
 
   // texture processing, rescaling and packing
-  convertAndDownscaleAllTextures(meshData.materials, basePath, meshData.textureFiles, opacityMaps);
-
-  recalculateBoundingBoxes(meshData);
+  convertAndDownscaleAllTextures(meshData.materials, basePath, meshData.textureFiles, opacityMaps, reuseConvertedTextures);
 
   // scene hierarchy conversion
+  const size_t firstNode = ourScene.hierarchy.size();
+
   traverse(scene, ourScene, scene->mRootNode, -1, 0);
+
+  // nodes reference aiMeshes, point them to the deduplicated meshes
+  for (auto& n : ourScene.meshForNode) {
+    if (n.first >= firstNode)
+      n.second = meshRemap[n.second];
+  }
+}
+
+void loadMeshFile(
+    const char* fileName, MeshData& meshData, Scene& ourScene, bool generateLODs, bool reuseConvertedTextures = false,
+    bool quantizeVertices = false)
+{
+  convertMeshFile(fileName, meshData, ourScene, generateLODs, nullptr, reuseConvertedTextures, quantizeVertices);
+}
+
+// streaming conversion with bounded memory: only materials and texture names are kept in 'meshData'
+void loadMeshFile(
+    const char* fileName, MeshDataWriter& writer, MeshData& meshData, Scene& ourScene, bool generateLODs,
+    bool reuseConvertedTextures = false, bool quantizeVertices = false)
+{
+  convertMeshFile(fileName, meshData, ourScene, generateLODs, &writer, reuseConvertedTextures, quantizeVertices);
+}
+
+// stamp of the Bistro source files, stored in the Bistro cache files to detect stale caches (see getFilesStamp())
+uint64_t getBistroSourcesStamp()
+{
+  return getFilesStamp({
+      "deps/src/bistro/Exterior/exterior.obj",
+      "deps/src/bistro/Exterior/exterior.mtl",
+      "deps/src/bistro/Interior/interior.obj",
+      "deps/src/bistro/Interior/interior.mtl",
+  });
+}
+
+// The only producer of the Bistro cache files, which are shared by Chapter08/03_LargeScene and Chapter10/Bistro.h: the exterior
+// and the interior are converted with LODs and merged into one scene, with the foliage merged, small static draws batched,
+// duplicate materials collapsed and meshlets built. The stats of the converted meshes are saved next to 'meshesFile'.
+// 'quantize' selects the quantized vertex layout (see convertAIMesh()), which all the Bistro renderers decode.
+MeshDataStats convertBistro(
+    const char* meshesFile, const char* materialsFile, const char* sceneFile, uint64_t sourcesStamp, bool compress,
+    bool reuseConvertedTextures = false, bool quantize = false)
+{
+  MeshData meshData_Exterior;
+  MeshData meshData_Interior;
+  Scene ourScene_Exterior;
+  Scene ourScene_Interior;
+
+  // the LOD chain is error-bounded and keeps mesh borders locked, see processLODs()
+  loadMeshFile("deps/src/bistro/Exterior/exterior.obj", meshData_Exterior, ourScene_Exterior, true, reuseConvertedTextures, quantize);
+  loadMeshFile("deps/src/bistro/Interior/interior.obj", meshData_Interior, ourScene_Interior, true, reuseConvertedTextures, quantize);
+
+  // merge some meshes
+  printf("[Unmerged] scene items: %u\n", (uint32_t)ourScene_Exterior.hierarchy.size());
+  mergeNodesWithMaterial(ourScene_Exterior, meshData_Exterior, "Foliage_Linde_Tree_Large_Orange_Leaves");
+  printf("[Merged orange leaves] scene items: %u\n", (uint32_t)ourScene_Exterior.hierarchy.size());
+  mergeNodesWithMaterial(ourScene_Exterior, meshData_Exterior, "Foliage_Linde_Tree_Large_Green_Leaves");
+  printf("[Merged green leaves]  scene items: %u\n", (uint32_t)ourScene_Exterior.hierarchy.size());
+  mergeNodesWithMaterial(ourScene_Exterior, meshData_Exterior, "Foliage_Linde_Tree_Large_Trunk");
+  printf("[Merged trunk]  scene items: %u\n", (uint32_t)ourScene_Exterior.hierarchy.size());
+
+  // batch thousands of small static draws, the Bistro is in centimeters: 20 m cells keep the batches cullable
+  const StaticBatchingParams batching = { .cellSize = 2000.0f };
+  batchStaticNodes(ourScene_Exterior, meshData_Exterior, batching);
+  batchStaticNodes(ourScene_Interior, meshData_Interior, batching);
+  printf("[Batched] scene items: %u + %u\n", (uint32_t)ourScene_Exterior.hierarchy.size(), (uint32_t)ourScene_Interior.hierarchy.size());
+
+  // merge everything into one big scene
+  MeshData meshData;
+  Scene ourScene;
+
+  mergeScenes(
+      ourScene,
+      {
+          &ourScene_Exterior,
+          &ourScene_Interior,
+      },
+      {},
+      {
+          static_cast<uint32_t>(meshData_Exterior.meshes.size()),
+          static_cast<uint32_t>(meshData_Interior.meshes.size()),
+      });
+  mergeMeshData(meshData, { &meshData_Exterior, &meshData_Interior });
+  mergeMaterialLists(
+      {
+          &meshData_Exterior.materials,
+          &meshData_Interior.materials,
+      },
+      {
+          &meshData_Exterior.textureFiles,
+          &meshData_Interior.textureFiles,
+      },
+      meshData.materials, meshData.textureFiles);
+
+  // byte-identical materials are common in Bistro
+  deduplicateMaterials(ourScene, meshData);
+
+  ourScene.localTransform[0] = glm::scale(vec3(0.01f)); // scale the Bistro
+  markAsChanged(ourScene, 0);
+
+  recalculateBoundingBoxes(meshData);
+
+  // after merging: the merged foliage meshes are large and benefit the most from per-cluster culling
+  buildMeshlets(meshData);
+
+  // the materials go last: their stamp tells the next run whether the converted textures can be reused
+  saveMeshData(meshesFile, meshData, compress, sourcesStamp);
+  saveScene(sceneFile, ourScene, sourcesStamp);
+  saveMeshDataMaterials(materialsFile, meshData, sourcesStamp);
+
+  const MeshDataStats stats = analyzeMeshData(meshData);
+  saveMeshStats((std::string(meshesFile) + ".stats.json").c_str(), stats);
+
+  return stats;
 }
@@ -1,5 +1,7 @@
 ﻿#pragma once
 
+#include <numeric>
+
 #include <meshoptimizer.h>
 
 #include "shared/UtilsGLTF.h"
@@ -15,8 +17,108 @@ struct DrawIndexedIndirectCommand {
 struct DrawData {
   uint32_t transformId;
   uint32_t materialId;
+  // dequantization of positions: pos = posOffset + posScale * in_pos (identity for float positions)
+  float posOffset[3];
+  float posScale[3];
+};
+
+// positions of quantized meshes are relative to their boxes (see hasQuantizedPositions())
+inline DrawData makeDrawData(uint32_t transformId, const Mesh& mesh, const BoundingBox& box, bool isQuantized)
+{
+  const vec3 posOffset = isQuantized ? box.min_ : vec3(0.0f);
+  const vec3 posScale  = isQuantized ? box.getSize() : vec3(1.0f);
+
+  return {
+    .transformId = transformId,
+    .materialId  = mesh.materialID,
+    .posOffset   = { posOffset.x, posOffset.y, posOffset.z },
+    .posScale    = { posScale.x, posScale.y, posScale.z },
+  };
+}
+
+// GPU index data of a set of draw commands: meshes with 16-bit indices (see Mesh::indexSize) are packed into 'indices16', rebased to
+// their smallest index (which moves to baseVertex), all other meshes into 'indices32'. The commands are reordered so that all
+// 16-bit draws come first, the first 'numCommands16' commands index 'indices16'. DrawData stays where baseInstance points to.
+struct DrawIndexData {
+  std::vector<uint16_t> indices16;
+  std::vector<uint32_t> indices32;
+  uint32_t numCommands16 = 0;
 };
 
+inline DrawIndexData packDrawIndices(
+    const MeshDataView& geometry, std::vector<DrawIndexedIndirectCommand>& commands, const std::vector<uint32_t>& meshIds)
+{
+  LVK_ASSERT(commands.size() == meshIds.size());
+
+  DrawIndexData out;
+
+  std::vector<uint32_t> order(commands.size());
+  std::iota(order.begin(), order.end(), 0u);
+  const auto end16 = std::stable_partition(
+      order.begin(), order.end(), [&](uint32_t i) { return geometry.meshes[meshIds[i]].indexSize == sizeof(uint16_t); });
+  out.numCommands16 = uint32_t(end16 - order.begin());
+
+  // meshes shared by several nodes are packed only once
+  constexpr uint32_t kNotPacked = ~0u;
+  std::vector<uint32_t> packedOffset(geometry.meshes.size(), kNotPacked);
+  std::vector<uint32_t> baseIndex(geometry.meshes.size(), 0);
+
+  // meshes are placed into their buffers first, so both buffers are allocated only once...
+  std::vector<uint32_t> packedMeshes;
+  uint32_t numIndices16 = 0;
+  uint32_t numIndices32 = 0;
+
+  for (uint32_t i : order) {
+    const uint32_t meshId = meshIds[i];
+    const Mesh& mesh      = geometry.meshes[meshId];
+
+    if (packedOffset[meshId] == kNotPacked) {
+      uint32_t& numIndices = mesh.indexSize == sizeof(uint16_t) ? numIndices16 : numIndices32;
+      packedOffset[meshId] = numIndices;
+      numIndices += mesh.lodOffset[mesh.lodCount] - mesh.lodOffset[0];
+      packedMeshes.push_back(meshId);
+    }
+  }
+
+  out.indices16.resize(numIndices16);
+  out.indices32.resize(numIndices32);
+
+  // ...and then filled
+  for (uint32_t meshId : packedMeshes) {
+    const Mesh& mesh = geometry.meshes[meshId];
+    const std::span<const uint32_t> indices =
+        geometry.indexData.subspan(mesh.indexOffset, mesh.lodOffset[mesh.lodCount] - mesh.lodOffset[0]);
+    if (mesh.indexSize == sizeof(uint16_t)) {
+      const uint32_t base = indices.empty() ? 0 : *std::min_element(indices.begin(), indices.end());
+      uint16_t* dst       = out.indices16.data() + packedOffset[meshId];
+      baseIndex[meshId]   = base;
+      for (uint32_t idx : indices) {
+        LVK_ASSERT(idx - base <= 0xFFFF);
+        *dst++ = uint16_t(idx - base);
+      }
+    } else {
+      std::copy(indices.begin(), indices.end(), out.indices32.begin() + packedOffset[meshId]);
+    }
+  }
+
+  std::vector<DrawIndexedIndirectCommand> sorted;
+  sorted.reserve(commands.size());
+
+  for (uint32_t i : order) {
+    const uint32_t meshId = meshIds[i];
+    const Mesh& mesh      = geometry.meshes[meshId];
+
+    DrawIndexedIndirectCommand cmd = commands[i];
+    cmd.firstIndex                 = packedOffset[meshId] + uint32_t(cmd.firstIndex - mesh.indexOffset);
+    cmd.baseVertex += (int32_t)baseIndex[meshId];
+    sorted.push_back(cmd);
+  }
+
+  commands = std::move(sorted);
+
+  return out;
+}
+
 // textureId -> TextureHandle
 using TextureCache = std::vector<lvk::Holder<lvk::TextureHandle>>;
 // textureId -> FileName
@@ -190,60 +292,143 @@ Material convertAIMaterial(const aiMaterial* M, std::vector<std::string>& files,
   return D;
 }
 
+// Relative (to the mesh extents) geometric error allowed for every simplification step of the LOD chain
+constexpr const float kLODStepMaxError = 0.02f;
+
+// Every LOD has about half the indices of the previous one. Simplification is attribute-aware (UV and normal seams are kept) and
+// locks open borders, so that adjacent pieces of a scene such as Bistro do not crack apart. The sloppy simplifier is a fallback
+// for steps where this cannot remove at least 10% of the indices within the error bound. 'outErrors' receives the object-space
+// error of every LOD relative to LOD0: the errors of all steps are added up, which is an upper bound. A summary of the LOD chain is
+// appended to 'log', so that meshes simplified in parallel can report in order.
 void processLODs(
-    std::vector<uint32_t>& indices, std::vector<uint8_t>& vertices, size_t vertexStride, std::vector<std::vector<uint32_t>>& outLods,
-    bool generateLods)
+    std::vector<uint32_t>& indices, const std::vector<uint8_t>& vertices, size_t vertexStride, std::vector<std::vector<uint32_t>>& outLods,
+    std::vector<float>& outErrors, bool generateLods, std::string& log)
 {
-  size_t verticesCountIn    = vertices.size() / vertexStride;
-  size_t targetIndicesCount = indices.size();
+  const size_t verticesCountIn = vertices.size() / vertexStride;
+  size_t targetIndicesCount    = indices.size();
 
-  printf("\n   LOD0: %i indices", int(indices.size()));
+  char line[128];
+  snprintf(line, sizeof(line), "\n   LOD0: %i indices", int(indices.size()));
+  log += line;
 
   outLods.push_back(indices);
+  outErrors.push_back(0.0f);
 
-  if (!generateLods)
+  if (!generateLods) {
+    log += "\n";
     return;
+  }
+
+  const float* positions = (const float*)vertices.data();
+
+  // normal, uv (see the vertex layout in convertAIMesh())
+  constexpr uint32_t kNumAttributes                 = 5;
+  constexpr float kAttributeWeights[kNumAttributes] = { 0.5f, 0.5f, 0.5f, 1.0f, 1.0f };
+
+  std::vector<float> attributes(verticesCountIn * kNumAttributes);
+
+  for (size_t i = 0; i != verticesCountIn; i++) {
+    uint32_t uv, normal;
+    memcpy(&uv, vertices.data() + i * vertexStride + sizeof(vec3), sizeof(uv));
+    memcpy(&normal, vertices.data() + i * vertexStride + sizeof(vec3) + sizeof(uint32_t), sizeof(normal));
+    const vec3 n = vec3(glm::unpackSnorm3x10_1x2(normal));
+    const vec2 t = glm::unpackHalf2x16(uv);
+    float* attr  = &attributes[i * kNumAttributes];
+    attr[0]      = n.x;
+    attr[1]      = n.y;
+    attr[2]      = n.z;
+    attr[3]      = t.x;
+    attr[4]      = t.y;
+  }
+
+  // relative errors reported by meshoptimizer are converted into object-space distances
+  const float errorScale = meshopt_simplifyScale(positions, verticesCountIn, vertexStride);
 
+  std::vector<uint32_t> lodIndices(indices.size());
+
+  float error = 0.0f;
   uint8_t LOD = 1;
 
   while (targetIndicesCount > 1024 && LOD < kMaxLODs) {
     targetIndicesCount /= 2;
 
-    bool sloppy = false;
+    bool sloppy     = false;
+    float stepError = 0.0f;
 
-    size_t numOptIndices = meshopt_simplify(
-        indices.data(), indices.data(), (uint32_t)indices.size(), (const float*)vertices.data(), verticesCountIn, vertexStride,
-        targetIndicesCount, 0.02f, 0, nullptr);
+    size_t numOptIndices = meshopt_simplifyWithAttributes(
+        lodIndices.data(), indices.data(), indices.size(), positions, verticesCountIn, vertexStride, attributes.data(),
+        kNumAttributes * sizeof(float), kAttributeWeights, kNumAttributes, nullptr, targetIndicesCount, kLODStepMaxError,
+        meshopt_SimplifyLockBorder, &stepError);
 
     // cannot simplify further
     if (static_cast<size_t>(numOptIndices * 1.1f) > indices.size()) {
-      if (LOD > 1) {
-        // try harder
-        numOptIndices = meshopt_simplifySloppy(
-            indices.data(), indices.data(), indices.size(), (const float*)vertices.data(), verticesCountIn, vertexStride,
-            targetIndicesCount, 0.02f, nullptr);
-        sloppy = true;
-        if (numOptIndices == indices.size())
-          break;
-      } else
+      // try harder
+      numOptIndices = meshopt_simplifySloppy(
+          lodIndices.data(), indices.data(), indices.size(), positions, verticesCountIn, vertexStride, targetIndicesCount,
+          kLODStepMaxError, &stepError);
+      sloppy = true;
+      if (numOptIndices == 0 || static_cast<size_t>(numOptIndices * 1.1f) > indices.size())
         break;
     }
 
-    indices.resize(numOptIndices);
+    indices.assign(lodIndices.begin(), lodIndices.begin() + numOptIndices);
 
     meshopt_optimizeVertexCache(indices.data(), indices.data(), indices.size(), verticesCountIn);
 
-    printf("\n   LOD%i: %i indices %s", int(LOD), int(numOptIndices), sloppy ? "[sloppy]" : "");
+    error += stepError * errorScale;
+
+    snprintf(line, sizeof(line), "\n   LOD%i: %i indices, error %g %s", int(LOD), int(numOptIndices), error, sloppy ? "[sloppy]" : "");
+    log += line;
 
     LOD++;
 
     outLods.push_back(indices);
+    outErrors.push_back(error);
+  }
+
+  log += "\n";
+}
+
+// Bump this every time the output of convertAIMesh() changes (stale converted meshes are then rejected by the mesh cache)
+constexpr const uint32_t kConvertAIMeshVersion = 3;
+
+// Rewrite optimized vertices (float3 pos, half2 uv, 2_10_10_10 normal) into the quantized 16-byte layout relative to 'box'
+// (see hasQuantizedPositions()). The round-trip error is checked by Ch08_Sample05_QuantizationCheck.
+void quantizeVertices(std::vector<uint8_t>& vertices, const BoundingBox& box)
+{
+  constexpr uint32_t kSrcStride = sizeof(vec3) + sizeof(uint32_t) + sizeof(uint32_t);
+  constexpr uint32_t kDstStride = 4 * sizeof(uint16_t) + sizeof(uint32_t) + sizeof(uint32_t);
+
+  const size_t numVertices = vertices.size() / kSrcStride;
+
+  std::vector<uint8_t> quantized;
+  quantized.reserve(numVertices * kDstStride);
+
+  for (size_t i = 0; i != numVertices; i++) {
+    const uint8_t* src = vertices.data() + i * kSrcStride;
+    vec3 pos;
+    uint32_t uv, normal;
+    memcpy(&pos, src, sizeof(pos));
+    memcpy(&uv, src + sizeof(vec3), sizeof(uv));
+    memcpy(&normal, src + sizeof(vec3) + sizeof(uint32_t), sizeof(normal));
+
+    uint16_t q[4];
+    quantizePosition(pos, box, q);
+
+    put(quantized, q);                                                              // pos   : ushort4 unorm
+    put(quantized, uv);                                                             // uv    : half2
+    put(quantized, encodeOctahedralNormal(vec3(glm::unpackSnorm3x10_1x2(normal)))); // normal: short2 snorm, octahedral
   }
 
-  printf("\n");
+  vertices = std::move(quantized);
 }
 
-Mesh convertAIMesh(const aiMesh* m, MeshData& meshData, uint32_t& indexOffset, uint32_t& vertexOffset, bool generateLODs)
+// 'quantize' selects the quantized vertex layout (see hasQuantizedPositions()); the mesh's BoundingBox is appended to
+// meshData.boxes either way, since quantized positions are relative to it. The LOD summary (see processLODs()) goes to 'lodLog',
+// or straight to stdout when it is null.
+Mesh convertAIMesh(
+    const aiMesh* m, MeshData& meshData, uint32_t& indexOffset, uint32_t& vertexOffset, bool generateLODs, bool quantize = false,
+    std::string* lodLog = nullptr)
 {
   static_assert(sizeof(aiVector3D) == 3 * sizeof(float));
 
@@ -307,7 +492,37 @@ Mesh convertAIMesh(const aiMesh* m, MeshData& meshData, uint32_t& indexOffset, u
   const uint32_t numVertices = static_cast<uint32_t>(vertices.size() / vertexStride);
 
   std::vector<std::vector<uint32_t>> outLods;
-  processLODs(srcIndices, vertices, vertexStride, outLods, generateLODs);
+  std::vector<float> outErrors;
+  std::string log;
+  processLODs(srcIndices, vertices, vertexStride, outLods, outErrors, generateLODs, log);
+  if (lodLog)
+    *lodLog = std::move(log);
+  else
+    printf("%s", log.c_str());
+
+  // all the remaining vertices are referenced by LOD0
+  BoundingBox box;
+  {
+    std::vector<vec3> positions(numVertices);
+    for (uint32_t i = 0; i != numVertices; i++) {
+      memcpy(&positions[i], vertices.data() + size_t(i) * vertexStride, sizeof(vec3));
+    }
+    box = BoundingBox(positions.data(), positions.size());
+  }
+
+  meshData.boxes.push_back(box);
+
+  if (quantize) {
+    // pos, uv, normal
+    meshData.streams = {
+      .attributes    = { { .location = 0, .format = lvk::VertexFormat_UShort4Norm, .offset = 0 },                          // pos
+                         { .location = 1, .format = lvk::VertexFormat_HalfFloat2, .offset = 4 * sizeof(uint16_t) },        // uv
+                         { .location = 2, .format = lvk::VertexFormat_Short2Norm, .offset = 4 * sizeof(uint16_t) + 4 } }, // n
+      .inputBindings = { { .stride = 4 * sizeof(uint16_t) + sizeof(uint32_t) + sizeof(uint32_t) } },
+    };
+
+    quantizeVertices(vertices, box);
+  }
 
   Mesh result = {
     .indexOffset  = indexOffset,
@@ -319,6 +534,7 @@ Mesh convertAIMesh(const aiMesh* m, MeshData& meshData, uint32_t& indexOffset, u
   for (size_t l = 0; l < outLods.size(); l++) {
     mergeVectors(meshData.indexData, outLods[l]);
     result.lodOffset[l] = numIndices;
+    result.lodError[l]  = outErrors[l];
     numIndices += (uint32_t)outLods[l].size();
   }
 
@@ -327,6 +543,7 @@ Mesh convertAIMesh(const aiMesh* m, MeshData& meshData, uint32_t& indexOffset, u
   result.lodOffset[outLods.size()] = numIndices;
   result.lodCount                  = (uint32_t)outLods.size();
   result.materialID                = m->mMaterialIndex;
+  result.indexSize                 = numVertices <= 0x10000 ? sizeof(uint16_t) : sizeof(uint32_t);
 
   indexOffset += numIndices;
   vertexOffset += numVertices;
@@ -340,15 +557,21 @@ public:
   VKMesh(
       const std::unique_ptr<lvk::IContext>& ctx, const MeshData& meshData, const Scene& scene, lvk::Format colorFormat,
       lvk::Format depthFormat, uint32_t numSamples = 1)
+  : VKMesh(ctx, MeshDataView(meshData), meshData, scene, colorFormat, depthFormat, numSamples)
+  {
+  }
+  // geometry is uploaded straight from 'geometry' (which can be a memory-mapped file), materials come from 'meshData'
+  VKMesh(
+      const std::unique_ptr<lvk::IContext>& ctx, const MeshDataView& geometry, const MeshData& meshData, const Scene& scene,
+      lvk::Format colorFormat, lvk::Format depthFormat, uint32_t numSamples = 1)
   : ctx(ctx)
-  , numIndices_((uint32_t)meshData.indexData.size())
-  , numMeshes_((uint32_t)meshData.meshes.size())
+  , numIndices_((uint32_t)geometry.indexData.size())
+  , numMeshes_((uint32_t)scene.meshForNode.size())
   , textureFiles_(meshData.textureFiles)
   {
-    const MeshFileHeader header = meshData.getMeshFileHeader();
+    const MeshFileHeader header = geometry.getMeshFileHeader();
 
-    const uint32_t* indices   = meshData.indexData.data();
-    const uint8_t* vertexData = meshData.vertexData.data();
+    const uint8_t* vertexData = geometry.vertexData.data();
 
     std::vector<GLTFMaterialDataGPU> materials;
 
@@ -365,13 +588,6 @@ public:
           .data      = vertexData,
           .debugName = "Buffer: vertex" },
         nullptr);
-    bufferIndices_ = ctx->createBuffer(
-        { .usage     = lvk::BufferUsageBits_Index,
-          .storage   = lvk::StorageType_Device,
-          .size      = header.indexDataSize,
-          .data      = indices,
-          .debugName = "Buffer: index" },
-        nullptr);
     bufferTransforms_ = ctx->createBuffer(
         { .usage     = lvk::BufferUsageBits_Storage,
           .storage   = lvk::StorageType_Device,
@@ -389,36 +605,61 @@ public:
 
     std::vector<DrawIndexedIndirectCommand> drawCommands;
     std::vector<DrawData> drawData;
+    std::vector<uint32_t> meshIds;
 
-    const uint32_t numCommands = header.meshCount;
+    // one command per node, several nodes can share a mesh
+    const uint32_t numCommands = numMeshes_;
 
     drawCommands.resize(numCommands);
     drawData.resize(numCommands);
+    meshIds.reserve(numCommands);
 
     DrawIndexedIndirectCommand* cmd = drawCommands.data();
     DrawData* dd                    = drawData.data();
 
-    LVK_ASSERT(scene.meshForNode.size() == numCommands);
-
     uint32_t ddIndex = 0;
 
+    const bool isQuantized = hasQuantizedPositions(geometry.streams);
+
     // prepare indirect commands buffer
     for (auto& i : scene.meshForNode) {
-      const Mesh& mesh = meshData.meshes[i.second];
+      const Mesh& mesh = geometry.meshes[i.second];
 
-      const uint32_t lod = std::min(0u, mesh.lodCount - 1); // TODO: implement dynamic lod
+      // the finest LOD (see VKMesh11::selectLODs() for LOD selection at runtime)
+      const uint32_t lod = 0;
 
       *cmd++ = {
         .count         = mesh.getLODIndicesCount(lod),
         .instanceCount = 1,
-        .firstIndex    = mesh.indexOffset, // + mesh.lodOffset[lod],
+        .firstIndex    = (uint32_t)mesh.getLODFirstIndex(lod),
         .baseVertex    = (int32_t)mesh.vertexOffset,
         .baseInstance  = ddIndex++,
       };
-      *dd++ = {
-        .transformId = i.first,
-        .materialId  = mesh.materialID,
-      };
+      *dd++ = makeDrawData(i.first, mesh, geometry.boxes[i.second], isQuantized);
+      meshIds.push_back(i.second);
+    }
+
+    const DrawIndexData indexData = packDrawIndices(geometry, drawCommands, meshIds);
+
+    numMeshes16_ = indexData.numCommands16;
+
+    if (!indexData.indices16.empty()) {
+      bufferIndices16_ = ctx->createBuffer(
+          { .usage     = lvk::BufferUsageBits_Index,
+            .storage   = lvk::StorageType_Device,
+            .size      = indexData.indices16.size() * sizeof(uint16_t),
+            .data      = indexData.indices16.data(),
+            .debugName = "Buffer: index (16-bit)" },
+          nullptr);
+    }
+    if (!indexData.indices32.empty()) {
+      bufferIndices32_ = ctx->createBuffer(
+          { .usage     = lvk::BufferUsageBits_Index,
+            .storage   = lvk::StorageType_Device,
+            .size      = indexData.indices32.size() * sizeof(uint32_t),
+            .data      = indexData.indices32.data(),
+            .debugName = "Buffer: index (32-bit)" },
+          nullptr);
     }
 
     bufferIndirect_ = ctx->createBuffer(
@@ -440,10 +681,17 @@ public:
     vert_ = loadShaderModule(ctx, "Chapter08/02_SceneGraph/src/main.vert");
     frag_ = loadShaderModule(ctx, "Chapter08/02_SceneGraph/src/main.frag");
 
+    // octahedral normals of the quantized vertex layout are decoded in the vertex shader
+    const uint32_t octahedralNormals               = isQuantized ? 1u : 0u;
+    const lvk::SpecializationConstantDesc specInfo = {
+      .entries = { { .constantId = 0, .size = sizeof(uint32_t) } }, .data = &octahedralNormals, .dataSize = sizeof(uint32_t)
+    };
+
     pipeline_ = ctx->createRenderPipeline({
-        .vertexInput      = meshData.streams,
+        .vertexInput      = geometry.streams,
         .smVert           = vert_,
         .smFrag           = frag_,
+        .specInfo         = specInfo,
         .color            = { { .format = colorFormat } },
         .depthFormat      = depthFormat,
         .cullMode         = lvk::CullMode_None,
@@ -452,9 +700,10 @@ public:
     });
 
     pipelineWireframe_ = ctx->createRenderPipeline({
-        .vertexInput  = meshData.streams,
+        .vertexInput  = geometry.streams,
         .smVert       = vert_,
         .smFrag       = frag_,
+        .specInfo     = specInfo,
         .color        = { { .format = colorFormat } },
         .depthFormat  = depthFormat,
         .cullMode     = lvk::CullMode_None,
@@ -469,7 +718,6 @@ public:
       lvk::ICommandBuffer& buf, const mat4& view, const mat4& proj, lvk::TextureHandle texSkyboxIrradiance = {},
       bool wireframe = false) const
   {
-    buf.cmdBindIndexBuffer(bufferIndices_, lvk::IndexFormat_UI32);
     buf.cmdBindVertexBuffer(0, bufferVertices_);
     buf.cmdBindRenderPipeline(wireframe ? pipelineWireframe_ : pipeline_);
     buf.cmdBindDepthState({ .compareOp = lvk::CompareOp_Less, .isDepthWriteEnabled = true });
@@ -488,7 +736,15 @@ public:
     };
     static_assert(sizeof(pc) <= 128);
     buf.cmdPushConstants(pc);
-    buf.cmdDrawIndexedIndirect(bufferIndirect_, 0, numMeshes_);
+    // all 16-bit draws come first in the indirect buffer, see packDrawIndices()
+    if (numMeshes16_) {
+      buf.cmdBindIndexBuffer(bufferIndices16_, lvk::IndexFormat_UI16);
+      buf.cmdDrawIndexedIndirect(bufferIndirect_, 0, numMeshes16_);
+    }
+    if (numMeshes_ > numMeshes16_) {
+      buf.cmdBindIndexBuffer(bufferIndices32_, lvk::IndexFormat_UI32);
+      buf.cmdDrawIndexedIndirect(bufferIndirect_, numMeshes16_ * sizeof(DrawIndexedIndirectCommand), numMeshes_ - numMeshes16_);
+    }
   }
   void updateGlobalTransforms(const mat4* data, size_t numMatrices) const
   {
@@ -506,10 +762,12 @@ public:
 public:
   const std::unique_ptr<lvk::IContext>& ctx;
 
-  uint32_t numIndices_ = 0;
-  uint32_t numMeshes_  = 0;
+  uint32_t numIndices_  = 0;
+  uint32_t numMeshes_   = 0; // draw commands (one per scene node with a mesh)
+  uint32_t numMeshes16_ = 0; // draws using 16-bit indices
 
-  lvk::Holder<lvk::BufferHandle> bufferIndices_;
+  lvk::Holder<lvk::BufferHandle> bufferIndices16_;
+  lvk::Holder<lvk::BufferHandle> bufferIndices32_;
   lvk::Holder<lvk::BufferHandle> bufferVertices_;
   lvk::Holder<lvk::BufferHandle> bufferIndirect_;
   lvk::Holder<lvk::BufferHandle> bufferTransforms_;
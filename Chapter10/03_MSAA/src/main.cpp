@@ -5,8 +5,9 @@
 int main()
 {
   MeshData meshData;
+  MeshDataView meshDataView;
   Scene scene;
-  loadBistro(meshData, scene);
+  loadBistro(meshDataView, meshData, scene);
 
   VulkanApp app({
       .initialCameraPos    = vec3(-19.261f, 8.465f, -7.317f),
@@ -44,8 +45,8 @@ int main()
   bool drawWireframe     = false;
   bool drawBoundingBoxes = false;
 
-  const VKMesh mesh(ctx, meshData, scene, ctx->getSwapchainFormat(), app.getDepthFormat());
-  const VKMesh meshMSAA(ctx, meshData, scene, ctx->getSwapchainFormat(), app.getDepthFormat(), kNumSamples);
+  const VKMesh mesh(ctx, meshDataView, meshData, scene, ctx->getSwapchainFormat(), app.getDepthFormat());
+  const VKMesh meshMSAA(ctx, meshDataView, meshData, scene, ctx->getSwapchainFormat(), app.getDepthFormat(), kNumSamples);
 
   LineCanvas3D canvas3d;
 
@@ -6,8 +6,9 @@
 int main()
 {
   MeshData meshData;
+  MeshDataView meshDataView;
   Scene scene;
-  loadBistro(meshData, scene);
+  loadBistro(meshDataView, meshData, scene);
 
   VulkanApp app({
       .initialCameraPos    = vec3(-19.261f, 8.465f, -7.317f),
@@ -160,7 +161,7 @@ int main()
   const Skybox skyBox(
       ctx, "data/immenstadter_horn_2k_prefilter.ktx", "data/immenstadter_horn_2k_irradiance.ktx", ctx->getSwapchainFormat(),
       app.getDepthFormat(), kNumSamples);
-  const VKMesh mesh(ctx, meshData, scene, ctx->getSwapchainFormat(), app.getDepthFormat(), kNumSamples);
+  const VKMesh mesh(ctx, meshDataView, meshData, scene, ctx->getSwapchainFormat(), app.getDepthFormat(), kNumSamples);
 
   app.run([&](uint32_t width, uint32_t height, float aspectRatio, float deltaSeconds) {
     const mat4 view = app.camera_.getViewMatrix();
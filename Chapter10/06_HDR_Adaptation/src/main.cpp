@@ -9,8 +9,9 @@
 int main()
 {
   MeshData meshData;
+  MeshDataView meshDataView;
   Scene scene;
-  loadBistro(meshData, scene);
+  loadBistro(meshDataView, meshData, scene);
 
   VulkanApp app({
       .initialCameraPos    = vec3(-19.261f, 8.465f, -7.317f),
@@ -27,7 +28,7 @@ int main()
   const Skybox skyBox(
       ctx, "data/immenstadter_horn_2k_prefilter.ktx", "data/immenstadter_horn_2k_irradiance.ktx", kOffscreenFormat, app.getDepthFormat(),
       kNumSamples);
-  const VKMesh mesh(ctx, meshData, scene, kOffscreenFormat, app.getDepthFormat(), kNumSamples);
+  const VKMesh mesh(ctx, meshDataView, meshData, scene, kOffscreenFormat, app.getDepthFormat(), kNumSamples);
 
   lvk::Holder<lvk::ShaderModuleHandle> compBrightPass        = loadShaderModule(ctx, "Chapter10/05_HDR/src/BrightPass.comp");
   lvk::Holder<lvk::ComputePipelineHandle> pipelineBrightPass = ctx->createComputePipeline({ .smComp = compBrightPass });
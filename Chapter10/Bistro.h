@@ -1,80 +1,190 @@
 ﻿#pragma once
 
 #include "shared/Scene/MergeUtil.h"
+#include "shared/Scene/MeshStats.h"
 #include "shared/Scene/Scene.h"
 #include "shared/Scene/VtxData.h"
 
 #include "Chapter08/SceneUtils.h"
 
+#include <chrono>
+#include <functional>
+
+#include <taskflow/taskflow.hpp>
+
+#if !defined(DEMO_QUANTIZE_MESHES)
+// 1 = store the precached geometry in the quantized 16-byte vertex layout (decoded in the vertex shaders, see quantization.sp)
+#define DEMO_QUANTIZE_MESHES 0
+#endif
+
 #if !defined(fileNameCachedMeshes) || !defined(fileNameCachedMaterials) || !defined(fileNameCachedHierarchy)
+#if DEMO_QUANTIZE_MESHES
+// the float layout of Chapter08/03_LargeScene cannot be shared, the quantized Bistro has its own cache
+#define fileNameCachedMeshes ".cache/ch10_bistro_quantized.meshes"
+#define fileNameCachedMaterials ".cache/ch10_bistro_quantized.materials"
+#define fileNameCachedHierarchy ".cache/ch10_bistro_quantized.scene"
+#else
 // by default, share the precached Bistro with Chapter08/03_LargeScene
 #define fileNameCachedMeshes ".cache/ch08_bistro.meshes"
 #define fileNameCachedMaterials ".cache/ch08_bistro.materials"
 #define fileNameCachedHierarchy ".cache/ch08_bistro.scene"
 #endif
+#endif
 
-void loadBistro(MeshData& meshData, Scene& scene) {
-  if (!isMeshDataValid(fileNameCachedMeshes) || !isMeshHierarchyValid(fileNameCachedHierarchy) ||
-      !isMeshMaterialsValid(fileNameCachedMaterials)) {
-    printf("No cached mesh data found. Precaching...\n\n");
-
-    MeshData meshData_Exterior;
-    MeshData meshData_Interior;
-    Scene ourScene_Exterior;
-    Scene ourScene_Interior;
-
-    // don't generate LODs because meshoptimizer fails on the Bistro mesh
-    loadMeshFile("deps/src/bistro/Exterior/exterior.obj", meshData_Exterior, ourScene_Exterior, false);
-    loadMeshFile("deps/src/bistro/Interior/interior.obj", meshData_Interior, ourScene_Interior, false);
-
-    // merge some meshes
-    printf("[Unmerged] scene items: %u\n", (uint32_t)ourScene_Exterior.hierarchy.size());
-    mergeNodesWithMaterial(ourScene_Exterior, meshData_Exterior, "Foliage_Linde_Tree_Large_Orange_Leaves");
-    printf("[Merged orange leaves] scene items: %u\n", (uint32_t)ourScene_Exterior.hierarchy.size());
-    mergeNodesWithMaterial(ourScene_Exterior, meshData_Exterior, "Foliage_Linde_Tree_Large_Green_Leaves");
-    printf("[Merged green leaves]  scene items: %u\n", (uint32_t)ourScene_Exterior.hierarchy.size());
-    mergeNodesWithMaterial(ourScene_Exterior, meshData_Exterior, "Foliage_Linde_Tree_Large_Trunk");
-    printf("[Merged trunk]  scene items: %u\n", (uint32_t)ourScene_Exterior.hierarchy.size());
-
-    // merge everything into one big scene
-    MeshData meshData;
-    Scene ourScene;
-
-    mergeScenes(
-        ourScene,
-        {
-            &ourScene_Exterior,
-            &ourScene_Interior,
-        },
-        {},
-        {
-            static_cast<uint32_t>(meshData_Exterior.meshes.size()),
-            static_cast<uint32_t>(meshData_Interior.meshes.size()),
-        });
-    mergeMeshData(meshData, { &meshData_Exterior, &meshData_Interior });
-    mergeMaterialLists(
-        {
-            &meshData_Exterior.materials,
-            &meshData_Interior.materials,
-        },
-        {
-            &meshData_Exterior.textureFiles,
-            &meshData_Interior.textureFiles,
-        },
-        meshData.materials, meshData.textureFiles);
-
-    ourScene.localTransform[0] = glm::scale(vec3(0.01f)); // scale the Bistro
-    markAsChanged(ourScene, 0);
-
-    recalculateBoundingBoxes(meshData);
-
-    saveMeshData(fileNameCachedMeshes, meshData);
-    saveMeshDataMaterials(fileNameCachedMaterials, meshData);
-    saveScene(fileNameCachedHierarchy, ourScene);
+#if !defined(fileNameMeshStatsBaseline)
+// the baseline is not shared with Chapter08/03_LargeScene, each pipeline accepts its own stats
+#define fileNameMeshStatsBaseline ".cache/ch10_bistro.stats.baseline.json"
+#endif
+
+#if !defined(DEMO_COMPRESS_MESHES)
+// 1 = store the precached geometry compressed with meshoptimizer (smaller on disk, but decoded into memory instead of being mapped)
+#define DEMO_COMPRESS_MESHES 0
+#endif
+
+// Decides in a few milliseconds whether the cache can be reused: only file stats, headers and small sections are read.
+//   - reuse: all cache files are intact and were built from the current source files;
+//   - partial rebuild: the sources did not change since the materials were cached, so the converted textures are still
+//     good and only the geometry and the scene are reconverted;
+//   - full rebuild: the sources changed (or nothing is cached), everything is reconverted.
+void precacheBistro() {
+  const auto start = std::chrono::high_resolution_clock::now();
+
+  const uint64_t sourcesStamp = getBistroSourcesStamp();
+
+  const bool isCacheValid = isMeshDataValid(fileNameCachedMeshes, sourcesStamp) &&
+                            isMeshMaterialsValid(fileNameCachedMaterials, sourcesStamp) &&
+                            isMeshHierarchyValid(fileNameCachedHierarchy, sourcesStamp);
+  const bool reuseTextures = !isCacheValid && getMeshMaterialsSourcesStamp(fileNameCachedMaterials) == sourcesStamp;
+
+  const double checkTimeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+  if (isCacheValid) {
+    printf("Cached mesh data is up to date (checked in %.2f ms)\n", checkTimeMs);
+    return;
   }
 
-  const MeshFileHeader header = loadMeshData(fileNameCachedMeshes, meshData);
+  if (reuseTextures) {
+    printf("Cached mesh data is incomplete or corrupted (checked in %.2f ms). Rebuilding, reusing converted textures...\n\n", checkTimeMs);
+  } else {
+    printf("No up-to-date cached mesh data found (checked in %.2f ms). Precaching...\n\n", checkTimeMs);
+  }
+
+  const MeshDataStats stats = convertBistro(
+      fileNameCachedMeshes, fileNameCachedMaterials, fileNameCachedHierarchy, sourcesStamp, DEMO_COMPRESS_MESHES, reuseTextures,
+      DEMO_QUANTIZE_MESHES);
+
+  // optimization quality of the converted meshes (delete the baseline to accept the current stats)
+  if (!checkMeshStats(fileNameMeshStatsBaseline, stats))
+    printf("WARNING: the precached meshes failed the mesh stats check against '%s'\n", fileNameMeshStatsBaseline);
+}
+
+void loadBistro(MeshData& meshData, Scene& scene) {
+  precacheBistro();
+
+  loadMeshData(fileNameCachedMeshes, meshData);
   loadMeshDataMaterials(fileNameCachedMaterials, meshData);
 
   loadScene(fileNameCachedHierarchy, scene);
 }
+
+// per-stage wall-clock timings of BistroLoader, in seconds
+struct BistroLoadingTimings {
+  double precache  = 0;
+  double meshes    = 0;
+  double materials = 0;
+  double scene     = 0;
+  double textures  = 0; // onMaterialsLoaded stage, including tasks spawned by it
+  double total     = 0;
+};
+
+// Asynchronous version of loadBistro(): the meshes, materials and scene hierarchy are read concurrently on a thread pool
+// while the app keeps initializing. 'onMaterialsLoaded' runs on the same pool as soon as the materials are loaded (e.g. to
+// start decoding textures) and may spawn more tasks into the subflow. Nothing passed to the constructor can be accessed
+// until wait() returns.
+class BistroLoader final
+{
+public:
+  BistroLoader(
+      MeshDataView& meshDataView, MeshData& meshData, Scene& scene,
+      std::function<void(tf::Subflow&, const MeshData&)> onMaterialsLoaded = nullptr)
+  : start_(Clock::now())
+  {
+    tf::Task precache = taskflow_.emplace([this] {
+      const auto start = Clock::now();
+      precacheBistro();
+      timings_.precache = secondsSince(start);
+    });
+    // the tasks below fill in different members of 'meshData'
+    tf::Task meshes = taskflow_.emplace([this, &meshDataView, &meshData] {
+      const auto start = Clock::now();
+      loadMeshDataView(fileNameCachedMeshes, meshDataView);
+      meshData.streams = meshDataView.streams;
+      meshData.meshes.assign(meshDataView.meshes.begin(), meshDataView.meshes.end());
+      meshData.boxes.assign(meshDataView.boxes.begin(), meshDataView.boxes.end());
+      meshData.spheres.assign(meshDataView.spheres.begin(), meshDataView.spheres.end());
+      meshData.lodBoxes.assign(meshDataView.lodBoxes.begin(), meshDataView.lodBoxes.end());
+      meshData.meshlets.assign(meshDataView.meshlets.begin(), meshDataView.meshlets.end());
+      timings_.meshes = secondsSince(start);
+    });
+    tf::Task materials = taskflow_.emplace([this, &meshData] {
+      const auto start = Clock::now();
+      loadMeshDataMaterials(fileNameCachedMaterials, meshData);
+      timings_.materials = secondsSince(start);
+    });
+    tf::Task hierarchy = taskflow_.emplace([this, &scene] {
+      const auto start = Clock::now();
+      loadScene(fileNameCachedHierarchy, scene);
+      timings_.scene = secondsSince(start);
+    });
+
+    precache.precede(meshes, materials, hierarchy);
+
+    if (onMaterialsLoaded) {
+      tf::Task textures = taskflow_.emplace([this, &meshData, callback = std::move(onMaterialsLoaded)](tf::Subflow& subflow) {
+        texturesStart_ = Clock::now();
+        callback(subflow, meshData);
+      });
+      // runs after the subflow has joined
+      tf::Task texturesDone = taskflow_.emplace([this] { timings_.textures = secondsSince(texturesStart_); });
+      materials.precede(textures);
+      textures.precede(texturesDone);
+    }
+
+    future_ = executor_.run(taskflow_);
+  }
+
+  bool isReady() const { return future_.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+
+  const BistroLoadingTimings& wait()
+  {
+    if (!finished_) {
+      future_.wait();
+      timings_.total = secondsSince(start_);
+      finished_      = true;
+      printf(
+          "Bistro loaded in %.3f s (precache %.3f s, meshes %.3f s, materials %.3f s, scene %.3f s, textures %.3f s)\n", timings_.total,
+          timings_.precache, timings_.meshes, timings_.materials, timings_.scene, timings_.textures);
+    }
+    return timings_;
+  }
+
+private:
+  using Clock = std::chrono::high_resolution_clock;
+
+  static double secondsSince(Clock::time_point start) { return std::chrono::duration<double>(Clock::now() - start).count(); }
+
+  Clock::time_point start_;
+  Clock::time_point texturesStart_;
+  BistroLoadingTimings timings_;
+  bool finished_ = false;
+
+  tf::Taskflow taskflow_;
+  tf::Executor executor_; // destroyed before the taskflow and the timings, waits for all running tasks
+  tf::Future<void> future_;
+};
+
+// Zero-copy version: index and vertex data stay in the memory-mapped cache file and are uploaded directly from there.
+// Only the small sections (vertex streams, mesh descriptors and bounding boxes) are copied into 'meshData'.
+void loadBistro(MeshDataView& meshDataView, MeshData& meshData, Scene& scene) {
+  BistroLoader(meshDataView, meshData, scene).wait();
+}
@@ -15,8 +15,9 @@ bool drawWireframe     = false;
 int main()
 {
   MeshData meshData;
+  MeshDataView meshDataView;
   Scene scene;
-  loadBistro(meshData, scene);
+  loadBistro(meshDataView, meshData, scene);
 
   VulkanApp app({
       .initialCameraPos    = vec3(-19.261f, 8.465f, -7.317f),
@@ -60,7 +61,7 @@ int main()
       ctx, "data/immenstadter_horn_2k_prefilter.ktx", "data/immenstadter_horn_2k_irradiance.ktx", ctx->getSwapchainFormat(),
       app.getDepthFormat(), kNumSamples);
 
-  const VKMesh11 mesh(ctx, meshData, scene, lvk::StorageType_HostVisible);
+  const VKMesh11 mesh(ctx, meshDataView, meshData, scene, lvk::StorageType_HostVisible);
   const VKPipeline11 pipeline(ctx, meshData.streams, ctx->getSwapchainFormat(), app.getDepthFormat(), kNumSamples);
 
   app.run([&](uint32_t width, uint32_t height, float aspectRatio, float deltaSeconds) {
@@ -82,10 +83,12 @@ int main()
       int numVisibleMeshes = 0;
       {
         DrawIndexedIndirectCommand* cmd = mesh.getDrawIndexedIndirectCommandPtr();
-        for (auto& p : scene.meshForNode) {
-          const BoundingBox box  = meshData.boxes[p.second].getTransformed(scene.globalTransform[p.first]);
-          const uint32_t count   = isBoxInFrustum(frustumPlanes, frustumCorners, box) ? 1 : 0;
-          (cmd++)->instanceCount = count;
+        for (uint32_t i = 0; i != mesh.numMeshes_; i++) {
+          const uint32_t transformId = mesh.drawData_[cmd->baseInstance].transformId;
+          const uint32_t meshId      = scene.meshForNode.at(transformId);
+          const BoundingBox box      = meshData.boxes[meshId].getTransformed(scene.globalTransform[transformId]);
+          const uint32_t count       = isBoxInFrustum(frustumPlanes, frustumCorners, box) ? 1 : 0;
+          (cmd++)->instanceCount     = count;
           numVisibleMeshes += count;
         }
         ctx->flushMappedMemory(mesh.indirectBuffer_.bufferIndirect_, 0, mesh.numMeshes_ * sizeof(DrawIndexedIndirectCommand));
@@ -100,9 +103,11 @@ int main()
       // render all bounding boxes (red)
       if (drawBoxes) {
         const DrawIndexedIndirectCommand* cmd = mesh.getDrawIndexedIndirectCommandPtr();
-        for (auto& p : scene.meshForNode) {
-          const BoundingBox box = meshData.boxes[p.second];
-          canvas3d.box(scene.globalTransform[p.first], box, (cmd++)->instanceCount ? vec4(0, 1, 0, 1) : vec4(1, 0, 0, 1));
+        for (uint32_t i = 0; i != mesh.numMeshes_; i++) {
+          const uint32_t transformId = mesh.drawData_[cmd->baseInstance].transformId;
+          const uint32_t meshId      = scene.meshForNode.at(transformId);
+          const BoundingBox box      = meshData.boxes[meshId];
+          canvas3d.box(scene.globalTransform[transformId], box, (cmd++)->instanceCount ? vec4(0, 1, 0, 1) : vec4(1, 0, 0, 1));
         }
       }
 
@@ -7,9 +7,10 @@
 #include "shared/LineCanvas.h"
 
 enum CullingMode {
-  CullingMode_None = 0,
-  CullingMode_CPU  = 1,
-  CullingMode_GPU  = 2,
+  CullingMode_None        = 0,
+  CullingMode_CPU         = 1,
+  CullingMode_GPU         = 2,
+  CullingMode_CPUClusters = 3, // per meshlet, see VKMesh11::cullClusters()
 };
 
 mat4 cullingView       = mat4(1.0f);
@@ -18,12 +19,17 @@ bool freezeCullingView = false;
 bool drawMeshes        = true;
 bool drawBoxes         = true;
 bool drawWireframe     = false;
+bool enableLODs        = true;
+float lodPixelError    = 2.0f; // screen-space error budget of LOD selection
+float minMeshletRadius = 1.0f; // in pixels
+bool cullBackfaces     = false;
 
 int main()
 {
   MeshData meshData;
+  MeshDataView meshDataView;
   Scene scene;
-  loadBistro(meshData, scene);
+  loadBistro(meshDataView, meshData, scene);
 
   VulkanApp app({
       .initialCameraPos    = vec3(-19.261f, 8.465f, -7.317f),
@@ -74,15 +80,21 @@ int main()
       cullingMode = CullingMode_CPU;
     if (key == GLFW_KEY_G)
       cullingMode = CullingMode_GPU;
+    if (key == GLFW_KEY_M)
+      cullingMode = CullingMode_CPUClusters;
   });
 
   const Skybox skyBox(
       ctx, "data/immenstadter_horn_2k_prefilter.ktx", "data/immenstadter_horn_2k_irradiance.ktx", ctx->getSwapchainFormat(),
       app.getDepthFormat(), kNumSamples);
 
-  const VKMesh11 mesh(ctx, meshData, scene, lvk::StorageType_HostVisible);
+  const VKMesh11 mesh(ctx, meshDataView, meshData, scene, lvk::StorageType_HostVisible);
   const VKPipeline11 pipeline(ctx, meshData.streams, ctx->getSwapchainFormat(), app.getDepthFormat(), kNumSamples);
 
+  VKIndirectBuffer11 clusterBuffer(ctx, mesh.maxClusterCommands_, lvk::StorageType_HostVisible);
+  ClusterCullingStats clusterStats;
+  double clusterCullingMs = 0.0;
+
   std::vector<BoundingBox> reorderedBoxes;
   reorderedBoxes.resize(scene.globalTransform.size());
 
@@ -104,6 +116,10 @@ int main()
     vec4 frustumCorners[8];
     uint32_t numMeshesToCull  = 0;
     uint32_t numVisibleMeshes = 0; // GPU
+    // LOD selection (see LODSelection)
+    float lodPixelScale       = 0.0f;
+    float lodPixelErrorBudget = 0.0f;
+    vec4 cameraPos            = vec4(0.0f);
   } emptyCullingData;
 
   int numVisibleMeshes = 0; // CPU
@@ -128,10 +144,14 @@ int main()
     uint64_t drawData;
     uint64_t AABBs;
     uint64_t meshes;
+    uint64_t drawLODs;
+    uint64_t transforms;
   } pcCulling = {
-    .commands = ctx->gpuAddress(mesh.indirectBuffer_.bufferIndirect_),
-    .drawData = ctx->gpuAddress(mesh.bufferDrawData_),
-    .AABBs    = ctx->gpuAddress(bufferAABBs),
+    .commands   = ctx->gpuAddress(mesh.indirectBuffer_.bufferIndirect_),
+    .drawData   = ctx->gpuAddress(mesh.bufferDrawData_),
+    .AABBs      = ctx->gpuAddress(bufferAABBs),
+    .drawLODs   = ctx->gpuAddress(mesh.bufferDrawLODs_),
+    .transforms = ctx->gpuAddress(mesh.bufferTransforms_),
   };
 
   app.run([&](uint32_t width, uint32_t height, float aspectRatio, float deltaSeconds) {
@@ -144,8 +164,17 @@ int main()
       if (!freezeCullingView)
         cullingView = app.camera_.getViewMatrix();
 
+      const LODSelection lodSelection = {
+        .cameraPos        = app.camera_.getPosition(),
+        .pixelScale       = 0.5f * float(height) * proj[1][1],
+        .pixelErrorBudget = enableLODs ? lodPixelError : 0.0f,
+      };
+
       CullingData cullingData = {
-        .numMeshesToCull = static_cast<uint32_t>(scene.meshForNode.size()),
+        .numMeshesToCull     = static_cast<uint32_t>(scene.meshForNode.size()),
+        .lodPixelScale       = lodSelection.pixelScale,
+        .lodPixelErrorBudget = lodSelection.pixelErrorBudget,
+        .cameraPos           = vec4(lodSelection.cameraPos, 1.0f),
       };
 
       getFrustumPlanes(proj * cullingView, cullingData.frustumPlanes);
@@ -159,26 +188,43 @@ int main()
           (cmd++)->instanceCount = 1;
         }
         ctx->flushMappedMemory(mesh.indirectBuffer_.bufferIndirect_, 0, mesh.numMeshes_ * sizeof(DrawIndexedIndirectCommand));
+        mesh.selectLODs(lodSelection, reorderedBoxes.data(), scene.globalTransform.data());
       } else if (cullingMode == CullingMode_CPU) {
         numVisibleMeshes = 0;
 
         DrawIndexedIndirectCommand* cmd = mesh.getDrawIndexedIndirectCommandPtr();
-        for (auto& p : scene.meshForNode) {
-          const BoundingBox box  = reorderedBoxes[p.first];
+        for (uint32_t i = 0; i != mesh.numMeshes_; i++) {
+          const BoundingBox box  = reorderedBoxes[mesh.drawData_[cmd->baseInstance].transformId];
           const uint32_t count   = isBoxInFrustum(cullingData.frustumPlanes, cullingData.frustumCorners, box) ? 1 : 0;
           (cmd++)->instanceCount = count;
           numVisibleMeshes += count;
         }
         ctx->flushMappedMemory(mesh.indirectBuffer_.bufferIndirect_, 0, mesh.numMeshes_ * sizeof(DrawIndexedIndirectCommand));
+        mesh.selectLODs(lodSelection, reorderedBoxes.data(), scene.globalTransform.data());
       } else if (cullingMode == CullingMode_GPU) {
+        // LODs are selected by the culling shader
         buf.cmdBindComputePipeline(pipelineCulling);
         pcCulling.meshes = ctx->gpuAddress(bufferCullingData[currentBufferId]);
         buf.cmdPushConstants(pcCulling);
         buf.cmdUpdateBuffer(bufferCullingData[currentBufferId], cullingData);
         buf.cmdDispatch(
             { 1 + cullingData.numMeshesToCull / 64 }, { .buffers = { lvk::BufferHandle(mesh.indirectBuffer_.bufferIndirect_) } });
+      } else if (cullingMode == CullingMode_CPUClusters) {
+        ClusterCulling clusterCulling = {
+          .cameraPos      = vec3(glm::inverse(cullingView)[3]),
+          .pixelScale     = lodSelection.pixelScale,
+          .minPixelRadius = minMeshletRadius,
+          .cullBackfaces  = cullBackfaces,
+        };
+        std::copy_n(cullingData.frustumPlanes, 6, clusterCulling.frustumPlanes);
+        const auto start = std::chrono::high_resolution_clock::now();
+        clusterStats     = mesh.cullClusters(clusterCulling, scene.globalTransform.data(), clusterBuffer);
+        clusterCullingMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        numVisibleMeshes = (int)clusterBuffer.drawCommands_.size();
       }
 
+      const VKIndirectBuffer11& indirectBuffer = cullingMode == CullingMode_CPUClusters ? clusterBuffer : mesh.indirectBuffer_;
+
       canvas3d.clear();
       canvas3d.setMatrix(proj * view);
 
@@ -188,9 +234,11 @@ int main()
       // render all bounding boxes (red)
       if (drawBoxes) {
         const DrawIndexedIndirectCommand* cmd = mesh.getDrawIndexedIndirectCommandPtr();
-        for (auto& p : scene.meshForNode) {
-          const BoundingBox box = meshData.boxes[p.second];
-          canvas3d.box(scene.globalTransform[p.first], box, (cmd++)->instanceCount ? vec4(0, 1, 0, 1) : vec4(1, 0, 0, 1));
+        for (uint32_t i = 0; i != mesh.numMeshes_; i++) {
+          const uint32_t transformId = mesh.drawData_[cmd->baseInstance].transformId;
+          const uint32_t meshId      = scene.meshForNode.at(transformId);
+          const BoundingBox box      = meshData.boxes[meshId];
+          canvas3d.box(scene.globalTransform[transformId], box, (cmd++)->instanceCount ? vec4(0, 1, 0, 1) : vec4(1, 0, 0, 1));
         }
       }
 
@@ -204,11 +252,11 @@ int main()
               .color = { { .loadOp = lvk::LoadOp_Clear, .storeOp = lvk::StoreOp_DontCare, .clearColor = { 1.0f, 1.0f, 1.0f, 1.0f } } },
               .depth = { .loadOp = lvk::LoadOp_Clear, .clearDepth = 1.0f }
       },
-          framebufferMSAA, { .buffers = { lvk::BufferHandle(mesh.indirectBuffer_.bufferIndirect_) } });
+          framebufferMSAA, { .buffers = { lvk::BufferHandle(indirectBuffer.bufferIndirect_) } });
       skyBox.draw(buf, view, proj);
       if (drawMeshes) {
         buf.cmdPushDebugGroupLabel("Mesh", 0xff0000ff);
-        mesh.draw(buf, pipeline, view, proj, skyBox.texSkyboxIrradiance, drawWireframe);
+        mesh.draw(buf, pipeline, view, proj, skyBox.texSkyboxIrradiance, drawWireframe, &indirectBuffer);
         buf.cmdPopDebugGroupLabel();
       }
       app.drawGrid(buf, proj, vec3(0, -1.0f, 0), kNumSamples);
@@ -250,9 +298,22 @@ int main()
         ImGui::RadioButton("None (N)", &cullingMode, CullingMode_None);
         ImGui::RadioButton("CPU  (C)", &cullingMode, CullingMode_CPU);
         ImGui::RadioButton("GPU  (G)", &cullingMode, CullingMode_GPU);
+        ImGui::RadioButton("CPU meshlets (M)", &cullingMode, CullingMode_CPUClusters);
         ImGui::Unindent(indentSize);
         ImGui::Checkbox("Freeze culling frustum (P)", &freezeCullingView);
         ImGui::Separator();
+        ImGui::Checkbox("LOD selection", &enableLODs);
+        ImGui::SliderFloat("Pixel error", &lodPixelError, 0.25f, 16.0f);
+        ImGui::Separator();
+        if (cullingMode == CullingMode_CPUClusters) {
+          ImGui::SliderFloat("Min meshlet radius (px)", &minMeshletRadius, 0.0f, 8.0f);
+          ImGui::Checkbox("Cull backfacing meshlets", &cullBackfaces);
+          ImGui::Text("Visible meshlets: %u of %u", clusterStats.numVisible, clusterStats.numMeshlets);
+          ImGui::Text(
+              "Culled: %u frustum, %u backfacing, %u small", clusterStats.numFrustumCulled, clusterStats.numBackfacing,
+              clusterStats.numSmall);
+          ImGui::Text("Culling time: %.3f ms", clusterCullingMs);
+        }
         ImGui::Text("Visible meshes: %i", numVisibleMeshes);
         ImGui::End();
       }
@@ -21,8 +21,9 @@ struct LightParams {
 int main()
 {
   MeshData meshData;
+  MeshDataView meshDataView;
   Scene scene;
-  loadBistro(meshData, scene);
+  loadBistro(meshDataView, meshData, scene);
 
   VulkanApp app({
       .initialCameraPos    = vec3(-19.261f, 8.465f, -7.317f),
@@ -90,7 +91,7 @@ int main()
       ctx, "data/immenstadter_horn_2k_prefilter.ktx", "data/immenstadter_horn_2k_irradiance.ktx", ctx->getSwapchainFormat(),
       app.getDepthFormat(), kNumSamples);
 
-  const VKMesh11 mesh(ctx, meshData, scene);
+  const VKMesh11 mesh(ctx, meshDataView, meshData, scene, lvk::StorageType_Device, true, true);
   const VKPipeline11 pipelineMesh(
       ctx, meshData.streams, ctx->getSwapchainFormat(), app.getDepthFormat(), kNumSamples,
       loadShaderModule(ctx, "Chapter11/03_DirectionalShadows/src/main.vert"),
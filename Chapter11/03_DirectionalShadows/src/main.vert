@@ -1,6 +1,7 @@
 ﻿//
 
 #include <Chapter11/03_DirectionalShadows/src/common.sp>
+#include <Chapter08/02_SceneGraph/src/quantization.sp>
 
 layout (location=0) in vec3 in_pos;
 layout (location=1) in vec2 in_tc;
@@ -13,13 +14,15 @@ layout (location=3) out flat uint materialId;
 layout (location=4) out vec4 shadowCoords;
 
 void main() {
-  mat4 model = pc.transforms.model[pc.drawData.dd[gl_BaseInstance].transformId];
-  gl_Position = pc.viewProj * model * vec4(in_pos, 1.0);
+  DrawData dd = pc.drawData.dd[gl_InstanceIndex];
+  mat4 model = pc.transforms.model[dd.transformId];
+  vec3 pos = dequantizePosition(dd, in_pos);
+  gl_Position = pc.viewProj * model * vec4(pos, 1.0);
   uv = vec2(in_tc.x, 1.0-in_tc.y);
-  normal = transpose( inverse(mat3(model)) ) * in_normal;
-  vec4 posClip = model * vec4(in_pos, 1.0);
+  normal = transpose( inverse(mat3(model)) ) * decodeNormal(in_normal);
+  vec4 posClip = model * vec4(pos, 1.0);
   worldPos = posClip.xyz/posClip.w;
-  materialId = pc.drawData.dd[gl_BaseInstance].materialId;
+  materialId = dd.materialId;
 
   shadowCoords = pc.light.viewProjBias * posClip;
 }
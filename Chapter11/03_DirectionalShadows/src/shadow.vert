@@ -1,6 +1,7 @@
 ﻿//
 
 #include <Chapter11/03_DirectionalShadows/src/common.sp>
+#include <Chapter08/02_SceneGraph/src/quantization.sp>
 
 layout (location=0) in vec3 in_pos;
 layout (location=1) in vec2 in_tc;
@@ -10,8 +11,9 @@ layout (location=0) out vec2 uv;
 layout (location=1) out flat uint materialId;
 
 void main() {
-  mat4 model = pc.transforms.model[pc.drawData.dd[gl_BaseInstance].transformId];
-  gl_Position = pc.viewProj * model * vec4(in_pos, 1.0);
+  DrawData dd = pc.drawData.dd[gl_InstanceIndex];
+  mat4 model = pc.transforms.model[dd.transformId];
+  gl_Position = pc.viewProj * model * vec4(dequantizePosition(dd, in_pos), 1.0);
   uv = vec2(in_tc.x, 1.0-in_tc.y);
-  materialId = pc.drawData.dd[gl_BaseInstance].materialId;
+  materialId = dd.materialId;
 }
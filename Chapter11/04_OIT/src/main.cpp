@@ -14,8 +14,9 @@ float opacityBoost         = 0.0f;
 int main()
 {
   MeshData meshData;
+  MeshDataView meshDataView;
   Scene scene;
-  loadBistro(meshData, scene);
+  loadBistro(meshDataView, meshData, scene);
 
   VulkanApp app({
       .initialCameraPos    = vec3(1.835f, 1.922f, 6.412f),
@@ -56,7 +57,7 @@ int main()
   const Skybox skyBox(
       ctx, "data/immenstadter_horn_2k_prefilter.ktx", "data/immenstadter_horn_2k_irradiance.ktx", ctx->getSwapchainFormat(),
       app.getDepthFormat(), kNumSamples);
-  const VKMesh11 mesh(ctx, meshData, scene);
+  const VKMesh11 mesh(ctx, meshDataView, meshData, scene, lvk::StorageType_Device, true, true);
   const VKPipeline11 pipelineOpaque(
       ctx, meshData.streams, ctx->getSwapchainFormat(), app.getDepthFormat(), kNumSamples,
       loadShaderModule(ctx, "Chapter11/04_OIT/src/main.vert"), loadShaderModule(ctx, "Chapter11/04_OIT/src/opaque.frag"));
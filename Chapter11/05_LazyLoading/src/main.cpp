@@ -27,8 +27,14 @@ struct LightParams {
 int main()
 {
   MeshData meshData;
+  MeshDataView meshDataView;
   Scene scene;
-  loadBistro(meshData, scene);
+  std::vector<LoadedTextureData> preloadedTextures;
+
+  // load the Bistro and decode its textures in the background while the Vulkan context and pipelines are being created
+  BistroLoader bistro(meshDataView, meshData, scene, [&preloadedTextures](tf::Subflow& subflow, const MeshData& md) {
+    preloadTextures(subflow, md, preloadedTextures);
+  });
 
   VulkanApp app({
       .initialCameraPos    = vec3(-19.261f, 8.465f, -7.317f),
@@ -96,7 +102,9 @@ int main()
       ctx, "data/immenstadter_horn_2k_prefilter.ktx", "data/immenstadter_horn_2k_irradiance.ktx", ctx->getSwapchainFormat(),
       app.getDepthFormat(), kNumSamples);
 
-  VKMesh11Lazy mesh(ctx, meshData, scene);
+  bistro.wait();
+
+  VKMesh11Lazy mesh(ctx, meshDataView, meshData, scene, lvk::StorageType_Device, std::move(preloadedTextures));
   const VKPipeline11 pipelineMesh(
       ctx, meshData.streams, ctx->getSwapchainFormat(), app.getDepthFormat(), kNumSamples,
       loadShaderModule(ctx, "Chapter11/03_DirectionalShadows/src/main.vert"),
@@ -39,6 +39,8 @@ enum CullingMode {
 mat4 cullingView       = mat4(1.0f);
 int cullingMode        = CullingMode_CPU;
 bool freezeCullingView = false;
+bool enableLODs        = true;
+float lodPixelError    = 2.0f; // screen-space error budget of LOD selection
 
 struct LightParams {
   float theta          = +90.0f;
@@ -52,8 +54,14 @@ struct LightParams {
 int main()
 {
   MeshData meshData;
+  MeshDataView meshDataView;
   Scene scene;
-  loadBistro(meshData, scene);
+  std::vector<LoadedTextureData> preloadedTextures;
+
+  // load the Bistro and decode its textures in the background while the Vulkan context and pipelines are being created
+  BistroLoader bistro(meshDataView, meshData, scene, [&preloadedTextures](tf::Subflow& subflow, const MeshData& md) {
+    preloadTextures(subflow, md, preloadedTextures);
+  });
 
   VulkanApp app({
       .initialCameraPos    = vec3(-18.621f, 4.621f, -6.359f),
@@ -239,7 +247,9 @@ int main()
   const Skybox skyBox(
       ctx, "data/immenstadter_horn_2k_prefilter.ktx", "data/immenstadter_horn_2k_irradiance.ktx", kOffscreenFormat, app.getDepthFormat(),
       kNumSamples);
-  VKMesh11Lazy mesh(ctx, meshData, scene);
+  bistro.wait();
+
+  VKMesh11Lazy mesh(ctx, meshDataView, meshData, scene, lvk::StorageType_Device, std::move(preloadedTextures));
   const VKPipeline11 pipelineOpaque(
       ctx, meshData.streams, kOffscreenFormat, app.getDepthFormat(), kNumSamples,
       loadShaderModule(ctx, "Chapter11/06_FinalDemo/src/main.vert"), loadShaderModule(ctx, "Chapter11/06_FinalDemo/src/opaque.frag"));
@@ -359,6 +369,10 @@ int main()
     vec4 frustumCorners[8];
     uint32_t numMeshesToCull  = 0;
     uint32_t numVisibleMeshes = 0; // GPU
+    // LOD selection (see LODSelection)
+    float lodPixelScale       = 0.0f;
+    float lodPixelErrorBudget = 0.0f;
+    vec4 cameraPos            = vec4(0.0f);
   } emptyCullingData;
 
   int numVisibleMeshes = 0; // CPU
@@ -384,10 +398,14 @@ int main()
     uint64_t drawData;
     uint64_t AABBs;
     uint64_t meshes;
+    uint64_t drawLODs;
+    uint64_t transforms;
   } pcCulling = {
-    .commands = 0,
-    .drawData = ctx->gpuAddress(mesh.bufferDrawData_),
-    .AABBs    = ctx->gpuAddress(bufferAABBs),
+    .commands   = 0,
+    .drawData   = ctx->gpuAddress(mesh.bufferDrawData_),
+    .AABBs      = ctx->gpuAddress(bufferAABBs),
+    .drawLODs   = ctx->gpuAddress(mesh.bufferDrawLODs_),
+    .transforms = ctx->gpuAddress(mesh.bufferTransforms_),
   };
 
   VKIndirectBuffer11 meshesOpaque(ctx, mesh.numMeshes_, lvk::StorageType_HostVisible);
@@ -544,8 +562,17 @@ int main()
     if (!freezeCullingView)
       cullingView = app.camera_.getViewMatrix();
 
+    const LODSelection lodSelection = {
+      .cameraPos        = app.camera_.getPosition(),
+      .pixelScale       = 0.5f * float(height) * proj[1][1],
+      .pixelErrorBudget = enableLODs ? lodPixelError : 0.0f,
+    };
+
     CullingData cullingData = {
-      .numMeshesToCull = static_cast<uint32_t>(meshesOpaque.drawCommands_.size()),
+      .numMeshesToCull     = static_cast<uint32_t>(meshesOpaque.drawCommands_.size()),
+      .lodPixelScale       = lodSelection.pixelScale,
+      .lodPixelErrorBudget = lodSelection.pixelErrorBudget,
+      .cameraPos           = vec4(lodSelection.cameraPos, 1.0f),
     };
 
     getFrustumPlanes(proj * cullingView, cullingData.frustumPlanes);
@@ -575,6 +602,7 @@ int main()
           (cmd++)->instanceCount = 1;
         }
         ctx->flushMappedMemory(meshesOpaque.bufferIndirect_, 0, meshesOpaque.drawCommands_.size() * sizeof(DrawIndexedIndirectCommand));
+        mesh.selectLODs(lodSelection, reorderedBoxes.data(), scene.globalTransform.data(), &meshesOpaque);
       } else if (cullingMode == CullingMode_CPU) {
         numVisibleMeshes =
             static_cast<uint32_t>(meshesTransparent.drawCommands_.size()); // all transparent meshes are visible - we don't cull them
@@ -587,7 +615,9 @@ int main()
           numVisibleMeshes += count;
         }
         ctx->flushMappedMemory(meshesOpaque.bufferIndirect_, 0, meshesOpaque.drawCommands_.size() * sizeof(DrawIndexedIndirectCommand));
+        mesh.selectLODs(lodSelection, reorderedBoxes.data(), scene.globalTransform.data(), &meshesOpaque);
       } else if (cullingMode == CullingMode_GPU) {
+        // LODs of the opaque meshes are selected by the culling shader
         buf.cmdBindComputePipeline(pipelineCulling);
         pcCulling.meshes   = ctx->gpuAddress(bufferCullingData[currentBufferId]);
         pcCulling.commands = ctx->gpuAddress(meshesOpaque.bufferIndirect_);
@@ -598,6 +628,9 @@ int main()
         buf.cmdDispatch({ 1 + cullingData.numMeshesToCull / 64 }, { .buffers = { lvk::BufferHandle(meshesOpaque.bufferIndirect_) } });
       }
 
+      // transparent meshes are not culled, their LODs are always selected on the CPU
+      mesh.selectLODs(lodSelection, reorderedBoxes.data(), scene.globalTransform.data(), &meshesTransparent);
+
       // 0. Update shadow map
       if (prevLight != light) {
         prevLight = light;
@@ -933,6 +966,9 @@ int main()
           ImGui::Unindent(indentSize);
           ImGui::Checkbox("Freeze culling frustum (P)", &freezeCullingView);
           ImGui::Separator();
+          ImGui::Checkbox("LOD selection", &enableLODs);
+          ImGui::SliderFloat("Pixel error", &lodPixelError, 0.25f, 16.0f);
+          ImGui::Separator();
           ImGui::Text("Visible meshes: %i", numVisibleMeshes);
           ImGui::Separator();
         }
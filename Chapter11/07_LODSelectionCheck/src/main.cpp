@@ -0,0 +1,156 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "Chapter11/VKMesh11.h"
+
+// Headless check of the LOD selection: a LOD must never get finer as the camera moves away or as the field of view narrows, and every
+// LOD switch happens where its projected error meets the budget. The camera distance and the field of view are swept across the LOD
+// error thresholds of a mesh for a few instance transforms. selectLOD() runs the code of 02_CullingGPU/src/LODSelection.sp, which
+// FrustumCulling.comp includes as well, so the checks cover the formula used by the GPU; the shader itself (how it reads its buffers)
+// is not run here.
+
+// FrustumCulling.comp reads DrawLODs as a std430 struct
+static_assert(sizeof(DrawLODs) == sizeof(uint32_t) * (1 + 3 * kMaxLODs));
+
+struct Instance {
+  const char* name;
+  mat4 transform;
+};
+
+uint32_t numChecks   = 0;
+uint32_t numFailures = 0;
+
+static void check(bool condition, const char* what, const char* instance, float fov, float budget, float distance)
+{
+  numChecks++;
+
+  if (condition)
+    return;
+
+  if (numFailures++ < 20)
+    printf("FAILED: %s (%s, fov %.0f deg, budget %.1f px, distance %g)\n", what, instance, fov, budget, distance);
+}
+
+int main()
+{
+  // 6 LODs with the growing errors of a typical simplified LOD chain (see processLODs())
+  Mesh mesh;
+  mesh.lodCount             = 6;
+  const float lodErrors[]   = { 0.0f, 0.002f, 0.005f, 0.01f, 0.02f, 0.05f };
+  const uint32_t lodSizes[] = { 3000, 1500, 750, 375, 186, 93 };
+  for (uint32_t l = 0; l != mesh.lodCount; l++) {
+    mesh.lodError[l]      = lodErrors[l];
+    mesh.lodOffset[l + 1] = mesh.lodOffset[l] + lodSizes[l];
+  }
+
+  const DrawLODs lods = makeDrawLODs(mesh);
+
+  const BoundingBox localBox(vec3(-1.0f, -0.5f, -2.0f), vec3(1.0f, 2.5f, 2.0f));
+
+  const Instance instances[] = {
+    { "identity", mat4(1.0f) },
+    { "scaled 0.01 (Bistro)", glm::scale(glm::translate(mat4(1.0f), vec3(0.05f, 0.0f, -0.02f)), vec3(0.01f)) },
+    { "rotated, non-uniform scale",
+      glm::scale(glm::rotate(glm::translate(mat4(1.0f), vec3(10.0f, -3.0f, 7.0f)), 0.7f, vec3(0, 1, 0)), vec3(3.0f, 1.0f, 0.5f)) },
+  };
+
+  const float kViewportHeight = 1080.0f;
+  const float kFOVs[]         = { 20.0f, 45.0f, 60.0f, 90.0f, 120.0f }; // degrees, in increasing order
+  const float kBudgets[]      = { 0.0f, 0.5f, 1.0f, 4.0f };               // pixels
+
+  // the camera moves away from a face and from a corner of the world-space box
+  const vec3 kDirections[] = { vec3(1.0f, 0.0f, 0.0f), glm::normalize(vec3(1.0f, 1.0f, 1.0f)) };
+
+  const uint32_t kNumDistances = 4000;
+  const float kMinDistance     = 1e-3f;
+  const float kMaxDistance     = 1e5f;
+
+  printf("Distances where LOD 'n' gets selected (identity instance, %.1f px budget):\n", kBudgets[2]);
+
+  for (const Instance& inst : instances) {
+    const BoundingBox worldBox = localBox.getTransformed(inst.transform);
+    const float worldScale     = getMaxScale(inst.transform);
+
+    const bool printThresholds = &inst == &instances[0];
+
+    for (float budget : kBudgets) {
+      std::vector<uint32_t> prevFOVLODs; // LODs selected with the previous (narrower) field of view at every distance
+
+      for (float fov : kFOVs) {
+        const mat4 proj = glm::perspective(glm::radians(fov), 16.0f / 9.0f, 0.1f, 200.0f);
+
+        const LODSelection sel = {
+          .pixelScale       = 0.5f * kViewportHeight * proj[1][1],
+          .pixelErrorBudget = budget,
+        };
+
+        auto selectCPU = [&](vec3 cameraPos) {
+          LODSelection s = sel;
+          s.cameraPos    = cameraPos;
+          return selectLOD(lods, worldBox, worldScale, s);
+        };
+
+        // inside the box nothing but LOD0 is acceptable
+        check(selectCPU(worldBox.getCenter()) == 0, "LOD0 inside the box", inst.name, fov, budget, 0.0f);
+
+        std::vector<uint32_t> fovLODs;
+        uint32_t selected = 0; // bit mask of all selected LODs
+
+        for (const vec3& dir : kDirections) {
+          uint32_t prevLOD = 0;
+
+          for (uint32_t i = 0; i != kNumDistances; i++) {
+            const float distance = kMinDistance * powf(kMaxDistance / kMinDistance, float(i) / float(kNumDistances - 1));
+            const vec3 from      = dir.y > 0.0f ? worldBox.max_ : vec3(worldBox.max_.x, worldBox.getCenter().y, worldBox.getCenter().z);
+            const vec3 cameraPos = from + dir * distance;
+
+            const uint32_t lod = selectCPU(cameraPos);
+
+            check(lod >= prevLOD, "LOD does not get finer with distance", inst.name, fov, budget, distance);
+            if (budget == 0.0f)
+              check(lod == 0, "zero budget selects LOD0", inst.name, fov, budget, distance);
+
+            fovLODs.push_back(lod);
+            selected |= 1u << lod;
+            prevLOD = lod;
+          }
+        }
+
+        // a wider field of view shrinks everything on screen, LODs can only get coarser
+        for (size_t i = 0; i != prevFOVLODs.size(); i++)
+          check(fovLODs[i] >= prevFOVLODs[i], "LOD does not get finer with a wider field of view", inst.name, fov, budget, 0.0f);
+        prevFOVLODs = std::move(fovLODs);
+
+        if (budget == 0.0f)
+          continue;
+
+        // the sweep crosses every threshold...
+        check(selected == (1u << mesh.lodCount) - 1, "every LOD is selected", inst.name, fov, budget, 0.0f);
+
+        if (printThresholds && budget == kBudgets[2])
+          printf("  fov %3.0f deg:", fov);
+
+        // ...and every LOD switches exactly where its projected error meets the budget
+        for (uint32_t l = 1; l != mesh.lodCount; l++) {
+          const float threshold = lods.error[l] * worldScale * sel.pixelScale / budget;
+          const vec3 from       = vec3(worldBox.max_.x, worldBox.getCenter().y, worldBox.getCenter().z);
+          const uint32_t below  = selectCPU(from + kDirections[0] * (threshold * 0.99f));
+          const uint32_t above  = selectCPU(from + kDirections[0] * (threshold * 1.01f));
+          check(below < l, "finer LOD below the threshold", inst.name, fov, budget, threshold);
+          check(above >= l, "LOD selected above the threshold", inst.name, fov, budget, threshold);
+          if (printThresholds && budget == kBudgets[2])
+            printf(" %u: %7.2f", l, threshold);
+        }
+
+        if (printThresholds && budget == kBudgets[2])
+          printf("\n");
+      }
+    }
+  }
+
+  printf("\n%u checks, %u failed\n", numChecks, numFailures);
+
+  return numFailures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
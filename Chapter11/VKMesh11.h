@@ -2,6 +2,121 @@
 
 #include "Chapter08/VKMesh08.h"
 
+// LOD table of a DrawData entry, indexed by baseInstance just like DrawData (see DrawLODs in FrustumCulling.comp)
+struct DrawLODs {
+  uint32_t lodCount;
+  uint32_t firstIndex[kMaxLODs]; // in the index buffer used by the draw command (see packDrawIndices())
+  uint32_t count[kMaxLODs];
+  float error[kMaxLODs]; // see Mesh::lodError
+};
+
+inline DrawLODs makeDrawLODs(const Mesh& mesh)
+{
+  DrawLODs lods = { .lodCount = std::clamp(mesh.lodCount, 1u, kMaxLODs) };
+
+  for (uint32_t l = 0; l != lods.lodCount; l++) {
+    lods.firstIndex[l] = mesh.lodOffset[l] - mesh.lodOffset[0]; // relative to LOD0 until the index data is packed
+    lods.count[l]      = mesh.getLODIndicesCount(l);
+    lods.error[l]      = mesh.lodError[l];
+  }
+
+  return lods;
+}
+
+struct LODSelection {
+  vec3 cameraPos         = vec3(0.0f);
+  float pixelScale       = 0.0f; // pixels covered by 1 unit at distance 1: 0.5 * viewportHeight * proj[1][1]
+  float pixelErrorBudget = 0.0f; // 0 selects LOD0 everywhere
+};
+
+// the LOD selection code of FrustumCulling.comp, compiled as C++ so that the CPU and the GPU select LODs with the very same code
+namespace glsl
+{
+using namespace glm;
+using uint = uint32_t;
+namespace
+{
+#include "Chapter11/02_CullingGPU/src/LODSelection.sp"
+} // namespace
+} // namespace glsl
+
+using glsl::getMaxScale;
+
+inline uint32_t selectLOD(const DrawLODs& lods, const BoundingBox& worldBox, float worldScale, const LODSelection& sel)
+{
+  return glsl::selectLOD(lods, worldBox.min_, worldBox.max_, worldScale, sel.cameraPos, sel.pixelScale, sel.pixelErrorBudget);
+}
+
+struct ClusterCulling {
+  vec4 frustumPlanes[6]; // world space, see getFrustumPlanes()
+  vec3 cameraPos       = vec3(0.0f);
+  float pixelScale     = 0.0f; // as in LODSelection
+  float minPixelRadius = 0.0f; // meshlets whose bounding sphere projects to a smaller radius are culled, 0 disables the test
+  // the demo pipelines draw both sides of all triangles (lvk::CullMode_None), so backfacing meshlets are kept by default
+  bool cullBackfaces = false;
+};
+
+struct ClusterCullingStats {
+  uint32_t numMeshlets      = 0;
+  uint32_t numFrustumCulled = 0;
+  uint32_t numBackfacing    = 0;
+  uint32_t numSmall         = 0;
+  uint32_t numVisible       = 0;
+};
+
+// Appends a draw command for every visible meshlet of a mesh instance to 'out'; 'lod0' is the command drawing LOD0 of that instance.
+// Does not touch the GPU, so it can be benchmarked on its own. Cones are transformed assuming 'model' has no shear.
+inline void cullMeshlets(
+    const ClusterCulling& c, std::span<const Meshlet> meshlets, const mat4& model, const DrawIndexedIndirectCommand& lod0,
+    std::vector<DrawIndexedIndirectCommand>& out, ClusterCullingStats& stats)
+{
+  const float scale = getMaxScale(model);
+  // mirroring transforms flip the winding of all triangles
+  const float coneSign = glm::determinant(glm::mat3(model)) < 0.0f ? -1.0f : 1.0f;
+
+  stats.numMeshlets += (uint32_t)meshlets.size();
+
+  for (const Meshlet& m : meshlets) {
+    const vec3 center  = transformPointAffine(model, m.center);
+    const float radius = m.radius * scale;
+
+    bool isInside = true;
+    for (int i = 0; i != 6 && isInside; i++) {
+      const vec4& p = c.frustumPlanes[i];
+      isInside      = glm::dot(vec3(p), center) + p.w >= -radius * glm::length(vec3(p));
+    }
+    if (!isInside) {
+      stats.numFrustumCulled++;
+      continue;
+    }
+
+    const vec3 dir       = center - c.cameraPos;
+    const float distance = glm::length(dir);
+
+    if (c.cullBackfaces && m.coneCutoff < 1.0f) {
+      const vec3 axis = coneSign * glm::normalize(glm::mat3(model) * m.coneAxis);
+      if (glm::dot(dir, axis) >= m.coneCutoff * distance + radius) {
+        stats.numBackfacing++;
+        continue;
+      }
+    }
+
+    if (c.minPixelRadius > 0.0f && distance > radius && radius * c.pixelScale < c.minPixelRadius * distance) {
+      stats.numSmall++;
+      continue;
+    }
+
+    out.push_back({
+        .count         = m.indexCount,
+        .instanceCount = 1,
+        .firstIndex    = lod0.firstIndex + m.firstIndex,
+        .baseVertex    = lod0.baseVertex,
+        .baseInstance  = lod0.baseInstance,
+    });
+    stats.numVisible++;
+  }
+}
+
 class VKIndirectBuffer11 final
 {
 public:
@@ -27,16 +142,40 @@ public:
     ctx_->upload(bufferIndirect_, drawCommands_.data(), sizeof(VkDrawIndexedIndirectCommand) * numCommands, sizeof(uint32_t));
   };
 
+  // keeps the relative order of commands, so the selected 16-bit draws still come first
   void selectTo(VKIndirectBuffer11& buf, const std::function<bool(const DrawIndexedIndirectCommand&)>& pred) const
   {
     buf.drawCommands_.clear();
-    for (const auto& c : drawCommands_) {
-      if (pred(c))
+    buf.numCommands16_ = 0;
+    for (size_t i = 0; i != drawCommands_.size(); i++) {
+      const DrawIndexedIndirectCommand& c = drawCommands_[i];
+      if (pred(c)) {
         buf.drawCommands_.push_back(c);
+        if (i < numCommands16_)
+          buf.numCommands16_++;
+      }
     }
     buf.uploadIndirectBuffer();
   }
 
+  // two draws: commands [0, numCommands16_) with 16-bit indices, the rest with 32-bit indices
+  void draw(lvk::ICommandBuffer& buf, lvk::BufferHandle indices16, lvk::BufferHandle indices32) const
+  {
+    const uint32_t numCommands32 = (uint32_t)drawCommands_.size() - numCommands16_;
+    // the count stored in the buffer covers all commands, maxDrawCount limits each draw to its own range
+    if (numCommands16_) {
+      buf.cmdBindIndexBuffer(indices16, lvk::IndexFormat_UI16);
+      buf.cmdDrawIndexedIndirectCount(
+          bufferIndirect_, sizeof(uint32_t), bufferIndirect_, 0, numCommands16_, sizeof(DrawIndexedIndirectCommand));
+    }
+    if (numCommands32) {
+      buf.cmdBindIndexBuffer(indices32, lvk::IndexFormat_UI32);
+      buf.cmdDrawIndexedIndirectCount(
+          bufferIndirect_, sizeof(uint32_t) + numCommands16_ * sizeof(DrawIndexedIndirectCommand), bufferIndirect_, 0, numCommands32,
+          sizeof(DrawIndexedIndirectCommand));
+    }
+  }
+
   DrawIndexedIndirectCommand* getDrawIndexedIndirectCommandPtr() const
   {
     LVK_ASSERT(ctx_->getMappedPtr(bufferIndirect_));
@@ -49,6 +188,9 @@ public:
   lvk::Holder<lvk::BufferHandle> bufferIndirect_;
 
   std::vector<DrawIndexedIndirectCommand> drawCommands_;
+
+  // the first numCommands16_ commands use 16-bit indices (see packDrawIndices())
+  uint32_t numCommands16_ = 0;
 };
 
 class VKPipeline11 final
@@ -61,10 +203,17 @@ public:
     vert_ = vert.valid() ? std::move(vert) : loadShaderModule(ctx, "Chapter08/02_SceneGraph/src/main.vert");
     frag_ = frag.valid() ? std::move(frag) : loadShaderModule(ctx, "Chapter08/02_SceneGraph/src/main.frag");
 
+    // octahedral normals of the quantized vertex layout are decoded in all the vertex shaders (see quantization.sp)
+    const uint32_t octahedralNormals               = hasQuantizedPositions(streams) ? 1u : 0u;
+    const lvk::SpecializationConstantDesc specInfo = {
+      .entries = { { .constantId = 0, .size = sizeof(uint32_t) } }, .data = &octahedralNormals, .dataSize = sizeof(uint32_t)
+    };
+
     pipeline_ = ctx->createRenderPipeline({
         .vertexInput      = streams,
         .smVert           = vert_,
         .smFrag           = frag_,
+        .specInfo         = specInfo,
         .color            = { { .format = colorFormat } },
         .depthFormat      = depthFormat,
         .cullMode         = lvk::CullMode_None,
@@ -76,6 +225,7 @@ public:
         .vertexInput  = streams,
         .smVert       = vert_,
         .smFrag       = frag_,
+        .specInfo     = specInfo,
         .color        = { { .format = colorFormat } },
         .depthFormat  = depthFormat,
         .cullMode     = lvk::CullMode_None,
@@ -100,17 +250,24 @@ class VKMesh11
 public:
   VKMesh11(
       const std::unique_ptr<lvk::IContext>& ctx, const MeshData& meshData, const Scene& scene,
-      lvk::StorageType indirectBufferStorage = lvk::StorageType_Device, bool preloadMaterials = true)
+      lvk::StorageType indirectBufferStorage = lvk::StorageType_Device, bool preloadMaterials = true, bool instancing = false)
+  : VKMesh11(ctx, MeshDataView(meshData), meshData, scene, indirectBufferStorage, preloadMaterials, instancing)
+  {
+  }
+  // geometry is uploaded straight from 'geometry' (which can be a memory-mapped file), materials come from 'meshData'
+  // 'instancing' draws all nodes sharing a mesh with one instanced command; culling per command (instanceCount = 0/1) then
+  // culls all instances together, so the culling demos keep it disabled
+  VKMesh11(
+      const std::unique_ptr<lvk::IContext>& ctx, const MeshDataView& geometry, const MeshData& meshData, const Scene& scene,
+      lvk::StorageType indirectBufferStorage = lvk::StorageType_Device, bool preloadMaterials = true, bool instancing = false)
   : ctx(ctx)
-  , numIndices_((uint32_t)meshData.indexData.size())
-  , numMeshes_((uint32_t)meshData.meshes.size())
-  , indirectBuffer_(ctx, meshData.getMeshFileHeader().meshCount, indirectBufferStorage)
+  , numIndices_((uint32_t)geometry.indexData.size())
+  , indirectBuffer_(ctx, scene.meshForNode.size(), indirectBufferStorage)
   , textureFiles_(meshData.textureFiles)
   {
-    const MeshFileHeader header = meshData.getMeshFileHeader();
+    const MeshFileHeader header = geometry.getMeshFileHeader();
 
-    const uint32_t* indices   = meshData.indexData.data();
-    const uint8_t* vertexData = meshData.vertexData.data();
+    const uint8_t* vertexData = geometry.vertexData.data();
 
     materialsCPU_ = meshData.materials;
     materialsGPU_.reserve(meshData.materials.size());
@@ -126,13 +283,6 @@ public:
           .data      = vertexData,
           .debugName = "Buffer: vertex" },
         nullptr);
-    bufferIndices_ = ctx->createBuffer(
-        { .usage     = lvk::BufferUsageBits_Index,
-          .storage   = lvk::StorageType_Device,
-          .size      = header.indexDataSize,
-          .data      = indices,
-          .debugName = "Buffer: index" },
-        nullptr);
     bufferTransforms_ = ctx->createBuffer(
         { .usage     = lvk::BufferUsageBits_Storage,
           .storage   = lvk::StorageType_Device,
@@ -148,52 +298,112 @@ public:
           .debugName = "Buffer: materials" },
         nullptr);
 
-    const uint32_t numCommands = header.meshCount;
+    // (node, mesh) pairs; sorted by mesh, nodes sharing a mesh get consecutive DrawData entries for one instanced command
+    std::vector<std::pair<uint32_t, uint32_t>> nodes(scene.meshForNode.begin(), scene.meshForNode.end());
 
-    indirectBuffer_.drawCommands_.resize(numCommands);
-    drawData_.resize(numCommands);
+    if (instancing)
+      std::stable_sort(nodes.begin(), nodes.end(), [](const auto& a, const auto& b) { return a.second < b.second; });
 
-    DrawIndexedIndirectCommand* cmd = indirectBuffer_.drawCommands_.data();
-    DrawData* dd                    = drawData_.data();
+    const bool isQuantized = hasQuantizedPositions(geometry.streams);
 
-    LVK_ASSERT(scene.meshForNode.size() == numCommands);
+    indirectBuffer_.drawCommands_.clear();
+    drawData_.reserve(nodes.size());
+    drawLODs_.reserve(nodes.size());
+    drawMeshlets_.reserve(nodes.size());
+    meshlets_.assign(geometry.meshlets.begin(), geometry.meshlets.end());
 
-    uint32_t ddIndex = 0;
+    std::vector<uint32_t> meshIds;
+    meshIds.reserve(nodes.size());
 
     // prepare indirect commands buffer
-    for (auto& i : scene.meshForNode) {
-      const Mesh& mesh = meshData.meshes[i.second];
+    for (size_t i = 0; i != nodes.size();) {
+      const uint32_t meshId = nodes[i].second;
+      const Mesh& mesh      = geometry.meshes[meshId];
+
+      // start with the finest LOD, see selectLODs()
+      const uint32_t lod = 0;
+
+      const uint32_t firstInstance = (uint32_t)drawData_.size();
+
+      do {
+        drawData_.push_back(makeDrawData(nodes[i].first, mesh, geometry.boxes[meshId], isQuantized));
+        drawLODs_.push_back(makeDrawLODs(mesh));
+        // meshes without meshlets are drawn as a whole by cullClusters()
+        const bool hasMeshlets = uint64_t(mesh.firstMeshlet) + mesh.meshletCount <= geometry.meshlets.size();
+        drawMeshlets_.push_back(hasMeshlets ? glm::uvec2(mesh.firstMeshlet, mesh.meshletCount) : glm::uvec2(0));
+        maxClusterCommands_ += std::max(drawMeshlets_.back().y, 1u);
+        i++;
+      } while (instancing && i != nodes.size() && nodes[i].second == meshId);
+
+      indirectBuffer_.drawCommands_.push_back({
+          .count         = mesh.getLODIndicesCount(lod),
+          .instanceCount = (uint32_t)drawData_.size() - firstInstance,
+          .firstIndex    = (uint32_t)mesh.getLODFirstIndex(lod),
+          .baseVertex    = (int32_t)mesh.vertexOffset,
+          .baseInstance  = firstInstance,
+      });
+      meshIds.push_back(meshId);
+    }
 
-      const uint32_t lod = std::min(0u, mesh.lodCount - 1); // TODO: implement dynamic lod
+    numMeshes_ = (uint32_t)indirectBuffer_.drawCommands_.size();
 
-      *cmd++ = {
-        .count         = mesh.getLODIndicesCount(lod),
-        .instanceCount = 1,
-        .firstIndex    = mesh.indexOffset, // + mesh.lodOffset[lod],
-        .baseVertex    = (int32_t)mesh.vertexOffset,
-        .baseInstance  = ddIndex++,
-      };
-      *dd++ = {
-        .transformId = i.first,
-        .materialId  = mesh.materialID,
-      };
-    }
+    if (instancing)
+      printf("Instancing: %u draw commands for %u nodes\n", numMeshes_, (uint32_t)nodes.size());
+
+    const DrawIndexData indexData = packDrawIndices(geometry, indirectBuffer_.drawCommands_, meshIds);
+
+    indirectBuffer_.numCommands16_ = indexData.numCommands16;
     indirectBuffer_.uploadIndirectBuffer();
 
+    // LOD offsets become absolute: all commands start with LOD0
+    for (const DrawIndexedIndirectCommand& c : indirectBuffer_.drawCommands_) {
+      for (uint32_t j = 0; j != c.instanceCount; j++) {
+        DrawLODs& lods = drawLODs_[c.baseInstance + j];
+        for (uint32_t l = 0; l != lods.lodCount; l++) {
+          lods.firstIndex[l] += c.firstIndex;
+        }
+      }
+    }
+
+    if (!indexData.indices16.empty()) {
+      bufferIndices16_ = ctx->createBuffer(
+          { .usage     = lvk::BufferUsageBits_Index,
+            .storage   = lvk::StorageType_Device,
+            .size      = indexData.indices16.size() * sizeof(uint16_t),
+            .data      = indexData.indices16.data(),
+            .debugName = "Buffer: index (16-bit)" },
+          nullptr);
+    }
+    if (!indexData.indices32.empty()) {
+      bufferIndices32_ = ctx->createBuffer(
+          { .usage     = lvk::BufferUsageBits_Index,
+            .storage   = lvk::StorageType_Device,
+            .size      = indexData.indices32.size() * sizeof(uint32_t),
+            .data      = indexData.indices32.data(),
+            .debugName = "Buffer: index (32-bit)" },
+          nullptr);
+    }
+
     bufferDrawData_ = ctx->createBuffer(
         { .usage     = lvk::BufferUsageBits_Storage,
           .storage   = lvk::StorageType_Device,
-          .size      = sizeof(DrawData) * numCommands,
+          .size      = sizeof(DrawData) * drawData_.size(),
           .data      = drawData_.data(),
           .debugName = "Buffer: drawData" },
         nullptr);
+    bufferDrawLODs_ = ctx->createBuffer(
+        { .usage     = lvk::BufferUsageBits_Storage,
+          .storage   = lvk::StorageType_Device,
+          .size      = sizeof(DrawLODs) * drawLODs_.size(),
+          .data      = drawLODs_.data(),
+          .debugName = "Buffer: drawLODs" },
+        nullptr);
   }
 
   void draw(
       lvk::ICommandBuffer& buf, const VKPipeline11& pipeline, const mat4& view, const mat4& proj,
       lvk::TextureHandle texSkyboxIrradiance = {}, bool wireframe = false, const VKIndirectBuffer11* indirectBuffer = nullptr) const
   {
-    buf.cmdBindIndexBuffer(bufferIndices_, lvk::IndexFormat_UI32);
     buf.cmdBindVertexBuffer(0, bufferVertices_);
     buf.cmdBindRenderPipeline(wireframe ? pipeline.pipelineWireframe_ : pipeline.pipeline_);
     buf.cmdBindDepthState({ .compareOp = lvk::CompareOp_Less, .isDepthWriteEnabled = true });
@@ -214,9 +424,7 @@ public:
     buf.cmdPushConstants(pc);
     if (!indirectBuffer)
       indirectBuffer = &indirectBuffer_;
-    buf.cmdDrawIndexedIndirectCount(
-        indirectBuffer->bufferIndirect_, sizeof(uint32_t), indirectBuffer->bufferIndirect_, 0, numMeshes_,
-        sizeof(DrawIndexedIndirectCommand));
+    indirectBuffer->draw(buf, bufferIndices16_, bufferIndices32_);
   }
 
   void draw(
@@ -224,33 +432,103 @@ public:
       const lvk::DepthState depthState = { .compareOp = lvk::CompareOp_Less, .isDepthWriteEnabled = true }, bool wireframe = false,
       const VKIndirectBuffer11* indirectBuffer = nullptr) const
   {
-    buf.cmdBindIndexBuffer(bufferIndices_, lvk::IndexFormat_UI32);
     buf.cmdBindVertexBuffer(0, bufferVertices_);
     buf.cmdBindRenderPipeline(wireframe ? pipeline.pipelineWireframe_ : pipeline.pipeline_);
     buf.cmdBindDepthState(depthState);
     buf.cmdPushConstants(pushConstants, pcSize);
     if (!indirectBuffer)
       indirectBuffer = &indirectBuffer_;
-    buf.cmdDrawIndexedIndirectCount(
-        indirectBuffer->bufferIndirect_, sizeof(uint32_t), indirectBuffer->bufferIndirect_, 0, numMeshes_,
-        sizeof(DrawIndexedIndirectCommand));
+    indirectBuffer->draw(buf, bufferIndices16_, bufferIndices32_);
   }
 
   DrawIndexedIndirectCommand* getDrawIndexedIndirectCommandPtr() const { return indirectBuffer_.getDrawIndexedIndirectCommandPtr(); };
 
+  // CPU LOD selection: rewrites count/firstIndex of all commands in a host-visible indirect buffer. World-space boxes and
+  // transforms are indexed by DrawData::transformId. Instanced commands use the LOD of their first instance.
+  void selectLODs(
+      const LODSelection& sel, const BoundingBox* worldBoxes, const mat4* transforms,
+      const VKIndirectBuffer11* indirectBuffer = nullptr) const
+  {
+    if (!indirectBuffer)
+      indirectBuffer = &indirectBuffer_;
+
+    const uint32_t numCommands      = (uint32_t)indirectBuffer->drawCommands_.size();
+    DrawIndexedIndirectCommand* cmd = indirectBuffer->getDrawIndexedIndirectCommandPtr();
+
+    for (uint32_t i = 0; i != numCommands; i++, cmd++) {
+      const DrawLODs& lods       = drawLODs_[cmd->baseInstance];
+      const uint32_t transformId = drawData_[cmd->baseInstance].transformId;
+      const uint32_t lod         = selectLOD(lods, worldBoxes[transformId], getMaxScale(transforms[transformId]), sel);
+      cmd->count                 = lods.count[lod];
+      cmd->firstIndex            = lods.firstIndex[lod];
+    }
+
+    ctx->flushMappedMemory(indirectBuffer->bufferIndirect_, 0, sizeof(uint32_t) + numCommands * sizeof(DrawIndexedIndirectCommand));
+  }
+
+  // CPU cluster culling: every instance of every command is replaced by a command per visible meshlet of its LOD0 (see cullMeshlets()),
+  // instances of meshes without meshlets are drawn as a whole. 'out' needs room for maxClusterCommands_ commands.
+  ClusterCullingStats cullClusters(const ClusterCulling& c, const mat4* transforms, VKIndirectBuffer11& out) const
+  {
+    ClusterCullingStats stats;
+
+    out.drawCommands_.clear();
+    out.numCommands16_ = 0;
+
+    for (uint32_t i = 0; i != indirectBuffer_.drawCommands_.size(); i++) {
+      const DrawIndexedIndirectCommand& cmd = indirectBuffer_.drawCommands_[i];
+      for (uint32_t j = 0; j != cmd.instanceCount; j++) {
+        const uint32_t instance   = cmd.baseInstance + j;
+        const glm::uvec2 meshlets = drawMeshlets_[instance];
+
+        const DrawIndexedIndirectCommand lod0 = {
+          .count         = drawLODs_[instance].count[0],
+          .instanceCount = 1,
+          .firstIndex    = drawLODs_[instance].firstIndex[0],
+          .baseVertex    = cmd.baseVertex,
+          .baseInstance  = instance,
+        };
+
+        if (meshlets.y) {
+          cullMeshlets(
+              c, { meshlets_.data() + meshlets.x, meshlets.y }, transforms[drawData_[instance].transformId], lod0, out.drawCommands_,
+              stats);
+        } else {
+          out.drawCommands_.push_back(lod0);
+        }
+      }
+      if (i < indirectBuffer_.numCommands16_)
+        out.numCommands16_ = (uint32_t)out.drawCommands_.size();
+    }
+
+    LVK_ASSERT(out.drawCommands_.size() <= maxClusterCommands_);
+
+    out.uploadIndirectBuffer();
+
+    return stats;
+  }
+
 public:
   const std::unique_ptr<lvk::IContext>& ctx;
 
   uint32_t numIndices_ = 0;
-  uint32_t numMeshes_  = 0;
+  uint32_t numMeshes_  = 0; // draw commands
+
+  // upper bound of the number of commands produced by cullClusters()
+  uint32_t maxClusterCommands_ = 0;
 
-  lvk::Holder<lvk::BufferHandle> bufferIndices_;
+  lvk::Holder<lvk::BufferHandle> bufferIndices16_;
+  lvk::Holder<lvk::BufferHandle> bufferIndices32_;
   lvk::Holder<lvk::BufferHandle> bufferVertices_;
   lvk::Holder<lvk::BufferHandle> bufferTransforms_;
   lvk::Holder<lvk::BufferHandle> bufferDrawData_;
+  lvk::Holder<lvk::BufferHandle> bufferDrawLODs_;
   lvk::Holder<lvk::BufferHandle> bufferMaterials_;
 
   std::vector<DrawData> drawData_;
+  std::vector<DrawLODs> drawLODs_;
+  std::vector<glm::uvec2> drawMeshlets_; // (firstMeshlet, meshletCount) of every DrawData entry in meshlets_
+  std::vector<Meshlet> meshlets_;
 
   VKIndirectBuffer11 indirectBuffer_;
 
@@ -60,6 +60,32 @@ LoadedTextureData loadTextureData(const char* fileName)
   };
 }
 
+// Decode all the textures referenced by the materials in parallel. This does not need a GPU context, so it can start as soon as
+// the materials are loaded (see BistroLoader) and the results passed to VKMesh11Lazy.
+void preloadTextures(tf::Subflow& subflow, const MeshData& meshData, std::vector<LoadedTextureData>& out)
+{
+  std::vector<int> textureIds;
+
+  for (const Material& mtl : meshData.materials) {
+    for (int id : { mtl.baseColorTexture, mtl.emissiveTexture, mtl.normalTexture, mtl.opacityTexture })
+      if (id != -1)
+        textureIds.push_back(id);
+  }
+
+  std::sort(textureIds.begin(), textureIds.end());
+  textureIds.erase(std::unique(textureIds.begin(), textureIds.end()), textureIds.end());
+
+  const uint32_t numTextures = static_cast<uint32_t>(textureIds.size());
+
+  out.resize(numTextures);
+
+  // the spawned tasks outlive this function
+  subflow.for_each_index(0u, numTextures, 1u, [ids = std::move(textureIds), &files = meshData.textureFiles, &out](int i) {
+    out[i]       = loadTextureData(files[ids[i]].c_str());
+    out[i].index = ids[i];
+  });
+}
+
 GLTFMaterialDataGPU convertToGPUMaterialLazy(
     const std::unique_ptr<lvk::IContext>& ctx, const Material& mat, const TextureFiles& files, TextureCache& cache,
     std::vector<LoadedTextureData>& loadedTextureData, std::mutex& loadingMutex)
@@ -107,10 +133,19 @@ public:
   VKMesh11Lazy(
       const std::unique_ptr<lvk::IContext>& ctx, const MeshData& meshData, const Scene& scene,
       lvk::StorageType indirectBufferStorage = lvk::StorageType_Device)
-  : VKMesh11(ctx, meshData, scene, indirectBufferStorage, false)
+  : VKMesh11Lazy(ctx, MeshDataView(meshData), meshData, scene, indirectBufferStorage)
+  {
+  }
+  VKMesh11Lazy(
+      const std::unique_ptr<lvk::IContext>& ctx, const MeshDataView& geometry, const MeshData& meshData, const Scene& scene,
+      lvk::StorageType indirectBufferStorage = lvk::StorageType_Device, std::vector<LoadedTextureData>&& preloadedTextures = {})
+  : VKMesh11(ctx, geometry, meshData, scene, indirectBufferStorage, false)
   {
     materialsGPU_.resize(materialsCPU_.size());
 
+    // textures decoded by preloadTextures() are already in the queue and will not be loaded again
+    loadedTextureData_ = std::move(preloadedTextures);
+
     // construct Taskflow
     taskflow_.for_each_index(0u, static_cast<uint32_t>(materialsCPU_.size()), 1u, [&](int i) {
       materialsGPU_[i] = convertToGPUMaterialLazy(ctx, materialsCPU_[i], textureFiles_, textureCache_, loadedTextureData_, loadingMutex_);
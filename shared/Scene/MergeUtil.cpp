@@ -1,43 +1,84 @@
 #include "shared/Scene/MergeUtil.h"
 #include "shared/Scene/Scene.h"
+#include "shared/Utils.h"
 
+#include <glm/gtc/packing.hpp>
+
+#include <meshoptimizer.h>
+
+#include <map>
+#include <string>
+#include <tuple>
 #include <unordered_map>
 
-static uint32_t shiftMeshIndices(MeshData& meshData, const std::vector<uint32_t>& meshesToMerge)
+static void shiftMeshIndices(MeshData& meshData, const std::vector<uint32_t>& meshesToMerge)
 {
-  uint32_t minVtxOffset = std::numeric_limits<uint32_t>::max();
+  uint64_t minVtxOffset = std::numeric_limits<uint64_t>::max();
 
   for (uint32_t i : meshesToMerge)
     minVtxOffset = std::min(meshData.meshes[i].vertexOffset, minVtxOffset);
 
-  uint32_t mergeCount = 0u; // calculated by summing index counts in meshesToMerge
-
-  // now shift all the indices in individual index blocks [use minVtxOffset]
+  // now shift all the indices (of all LODs) in individual index blocks [use minVtxOffset]
   for (uint32_t i : meshesToMerge) {
     Mesh& m = meshData.meshes[i];
     // for how much should we shift the indices in mesh [m]
-    const uint32_t delta    = m.vertexOffset - minVtxOffset;
-    const uint32_t idxCount = m.getLODIndicesCount(0);
+    const uint32_t delta    = uint32_t(m.vertexOffset - minVtxOffset);
+    const uint32_t idxCount = m.lodOffset[m.lodCount] - m.lodOffset[0];
     for (uint32_t ii = 0u; ii < idxCount; ii++)
       meshData.indexData[m.indexOffset + ii] += delta;
 
     m.vertexOffset = minVtxOffset;
-
-    // sum all the deleted meshes' indices
-    mergeCount += idxCount;
   }
+}
 
-  return meshData.indexData.size() - mergeCount;
+// Quantized positions are relative to the box of their mesh: re-encode the vertices of all meshesToMerge relative to
+// their combined box, so the merged mesh can be drawn with one set of dequantization parameters
+static void requantizeMeshes(MeshData& md, const std::vector<uint32_t>& meshesToMerge, const BoundingBox& mergedBox)
+{
+  const uint32_t stride = md.streams.getVertexSize();
+
+  std::vector<bool> visited(md.vertexData.size() / stride);
+
+  for (uint32_t i : meshesToMerge) {
+    const Mesh& m = md.meshes[i];
+    for (uint32_t j = 0; j != m.lodOffset[m.lodCount] - m.lodOffset[0]; j++) {
+      const uint64_t v = md.indexData[m.indexOffset + j] + m.vertexOffset;
+      if (visited[v])
+        continue;
+      visited[v] = true;
+      uint16_t* q = reinterpret_cast<uint16_t*>(md.vertexData.data() + v * stride);
+      quantizePosition(dequantizePosition(q, md.boxes[i]), mergedBox, q);
+    }
+  }
 }
 
 // All the meshesToMerge now have the same vertexOffset and individual index values are shifted by appropriate amount
 // Here we move all the indices to appropriate places in the new index array
 static void mergeIndexArray(MeshData& md, const std::vector<uint32_t>& meshesToMerge, std::unordered_map<uint32_t, uint32_t>& oldToNew)
 {
-  std::vector<uint32_t> newIndices(md.indexData.size());
+  shiftMeshIndices(md, meshesToMerge);
+
+  // the merged mesh gets as many LODs as the most detailed of meshesToMerge, the meshes with fewer LODs repeat their last
+  // LOD in the coarser ones (as in batchStaticNodes())
+  uint32_t mergedLODCount = 0;
+  for (uint32_t i : meshesToMerge)
+    mergedLODCount = std::max(mergedLODCount, std::min(md.meshes[i].lodCount, kMaxLODs));
+
+  uint32_t copyCount  = 0;
+  uint32_t mergeCount = 0;
+  for (size_t midx = 0u; midx < md.meshes.size(); midx++) {
+    if (!std::binary_search(meshesToMerge.begin(), meshesToMerge.end(), midx))
+      copyCount += md.meshes[midx].lodOffset[md.meshes[midx].lodCount] - md.meshes[midx].lodOffset[0];
+  }
+  for (uint32_t l = 0; l != mergedLODCount; l++) {
+    for (uint32_t i : meshesToMerge)
+      mergeCount += md.meshes[i].getLODIndicesCount(std::min(l, md.meshes[i].lodCount - 1));
+  }
+
+  std::vector<uint32_t> newIndices(copyCount + mergeCount);
   // Two offsets in the new indices array (one begins at the start, the second one after all the copied indices)
   uint32_t copyOffset  = 0;
-  uint32_t mergeOffset = shiftMeshIndices(md, meshesToMerge);
+  uint32_t mergeOffset = copyCount;
 
   const size_t mergedMeshIndex = md.meshes.size() - meshesToMerge.size();
   uint32_t newIndex            = 0u;
@@ -47,27 +88,163 @@ static void mergeIndexArray(MeshData& md, const std::vector<uint32_t>& meshesToM
     oldToNew[midx] = shouldMerge ? mergedMeshIndex : newIndex;
     newIndex += shouldMerge ? 0 : 1;
 
+    if (shouldMerge)
+      continue;
+
     Mesh& mesh              = md.meshes[midx];
-    const uint32_t idxCount = mesh.getLODIndicesCount(0);
-    // move all indices to the new array at mergeOffset
-    const auto start          = md.indexData.begin() + mesh.indexOffset;
-    mesh.indexOffset          = copyOffset;
-    uint32_t* const offsetPtr = shouldMerge ? &mergeOffset : &copyOffset;
-    std::copy(start, start + idxCount, newIndices.begin() + *offsetPtr);
-    *offsetPtr += idxCount;
-  }
-
-  md.indexData = newIndices;
-
-  // all the merged indices are now in lastMesh
-  Mesh lastMesh         = md.meshes[meshesToMerge[0]];
-  lastMesh.indexOffset  = copyOffset;
-  lastMesh.lodOffset[0] = copyOffset;
-  lastMesh.lodOffset[1] = mergeOffset;
-  lastMesh.lodCount     = 1;
+    const uint32_t idxCount = mesh.lodOffset[mesh.lodCount] - mesh.lodOffset[0];
+    // move all indices to the new array at copyOffset
+    const auto start = md.indexData.begin() + mesh.indexOffset;
+    mesh.indexOffset = copyOffset;
+    std::copy(start, start + idxCount, newIndices.begin() + copyOffset);
+    copyOffset += idxCount;
+  }
+
+  // all the merged indices go into lastMesh, LOD by LOD
+  Mesh lastMesh        = md.meshes[meshesToMerge[0]];
+  lastMesh.indexOffset = copyOffset;
+  lastMesh.lodCount    = mergedLODCount;
+
+  for (uint32_t l = 0; l != kMaxLODs; l++) {
+    lastMesh.lodError[l] = 0.0f;
+    for (uint32_t i : meshesToMerge)
+      lastMesh.lodError[l] = std::max(lastMesh.lodError[l], md.meshes[i].lodError[std::min(l, md.meshes[i].lodCount - 1)]);
+  }
+
+  for (uint32_t l = 0; l != mergedLODCount; l++) {
+    lastMesh.lodOffset[l] = mergeOffset;
+    for (uint32_t i : meshesToMerge) {
+      const Mesh& mesh     = md.meshes[i];
+      const uint32_t lod   = std::min(l, mesh.lodCount - 1);
+      const auto start     = md.indexData.begin() + mesh.getLODFirstIndex(lod);
+      const uint32_t count = mesh.getLODIndicesCount(lod);
+      std::copy(start, start + count, newIndices.begin() + mergeOffset);
+      mergeOffset += count;
+    }
+  }
+  lastMesh.lodOffset[mergedLODCount] = mergeOffset;
+
+  md.indexData = std::move(newIndices);
+
+  lastMesh.indexSize = getMeshIndexSize(lastMesh, md.indexData);
+  // meshlets of the merged mesh have to be rebuilt (see buildMeshlets()), the ones of all other meshes are still valid
+  lastMesh.firstMeshlet = 0;
+  lastMesh.meshletCount = 0;
   md.meshes.push_back(lastMesh);
 }
 
+// The merged mesh is a concatenation of independently optimized meshes spread over a vertex range shared with other meshes:
+// re-optimize each of its LODs as a whole (as in convertAIMesh()) and move its vertices into a compact block at the end of the
+// vertex data.
+// The vertices which are not referenced by any mesh anymore are removed.
+static void optimizeMergedMesh(MeshData& md, uint32_t meshIndex)
+{
+  const uint32_t stride      = md.streams.getVertexSize();
+  const uint32_t numVertices = (uint32_t)(md.vertexData.size() / stride);
+  const bool isQuantized     = hasQuantizedPositions(md.streams);
+
+  LVK_ASSERT(isQuantized || md.streams.attributes[0].format == lvk::VertexFormat_Float3);
+
+  Mesh& merged = md.meshes[meshIndex];
+
+  uint32_t* indices         = md.indexData.data() + merged.indexOffset;
+  const uint32_t numIndices = merged.lodOffset[merged.lodCount] - merged.lodOffset[0];
+
+  // 1) optimize the merged mesh using its own vertex numbering, shared by all its LODs
+  std::vector<uint32_t> localToGlobal;
+  std::vector<uint32_t> globalToLocal(numVertices, ~0u);
+  std::vector<uint32_t> localIndices(numIndices);
+
+  for (uint32_t i = 0; i != numIndices; i++) {
+    const uint32_t v = uint32_t(merged.vertexOffset + indices[i]);
+    if (globalToLocal[v] == ~0u) {
+      globalToLocal[v] = (uint32_t)localToGlobal.size();
+      localToGlobal.push_back(v);
+    }
+    localIndices[i] = globalToLocal[v];
+  }
+
+  const uint32_t numLocalVertices = (uint32_t)localToGlobal.size();
+
+  std::vector<vec3> positions(numLocalVertices);
+
+  for (uint32_t v = 0; v != numLocalVertices; v++) {
+    const uint8_t* vertex = md.vertexData.data() + size_t(localToGlobal[v]) * stride;
+    if (isQuantized) {
+      uint16_t q[4];
+      memcpy(q, vertex, sizeof(q));
+      positions[v] = dequantizePosition(q, md.boxes[meshIndex]);
+    } else {
+      memcpy(&positions[v], vertex, sizeof(vec3));
+    }
+  }
+
+  std::vector<uint32_t> fetchRemap(numLocalVertices);
+
+  for (uint32_t l = 0; l != merged.lodCount; l++) {
+    uint32_t* lodIndices         = localIndices.data() + (merged.lodOffset[l] - merged.lodOffset[0]);
+    const uint32_t numLodIndices = merged.getLODIndicesCount(l);
+    meshopt_optimizeVertexCache(lodIndices, lodIndices, numLodIndices, numLocalVertices);
+    meshopt_optimizeOverdraw(lodIndices, lodIndices, numLodIndices, &positions[0].x, numLocalVertices, sizeof(vec3), 1.05f);
+  }
+  // LOD0 comes first, so its vertices are fetched in order
+  meshopt_optimizeVertexFetchRemap(fetchRemap.data(), localIndices.data(), numIndices, numLocalVertices);
+  meshopt_remapIndexBuffer(localIndices.data(), localIndices.data(), numIndices, fetchRemap.data());
+
+  // 2) the vertices of all the other meshes are kept in the same order
+  std::vector<bool> isUsed(numVertices, false);
+
+  for (size_t m = 0; m != md.meshes.size(); m++) {
+    const Mesh& mesh          = md.meshes[m];
+    const uint32_t* idx       = md.indexData.data() + mesh.indexOffset;
+    const uint32_t numMeshIdx = mesh.lodOffset[mesh.lodCount] - mesh.lodOffset[0];
+    for (uint32_t i = 0; m != meshIndex && i != numMeshIdx; i++)
+      isUsed[mesh.vertexOffset + idx[i]] = true;
+  }
+
+  std::vector<uint32_t> oldToNew(numVertices, ~0u);
+  std::vector<uint8_t> vertexData;
+
+  vertexData.reserve(md.vertexData.size());
+
+  for (uint32_t v = 0; v != numVertices; v++) {
+    if (!isUsed[v])
+      continue;
+    oldToNew[v]           = (uint32_t)(vertexData.size() / stride);
+    const uint8_t* vertex = md.vertexData.data() + size_t(v) * stride;
+    vertexData.insert(vertexData.end(), vertex, vertex + stride);
+  }
+
+  for (size_t m = 0; m != md.meshes.size(); m++) {
+    Mesh& mesh                = md.meshes[m];
+    uint32_t* idx             = md.indexData.data() + mesh.indexOffset;
+    const uint32_t numMeshIdx = mesh.lodOffset[mesh.lodCount] - mesh.lodOffset[0];
+    if (m == meshIndex || !numMeshIdx)
+      continue;
+    // the order is preserved, so the smallest index stays the smallest one
+    const uint32_t newOffset = oldToNew[mesh.vertexOffset + *std::min_element(idx, idx + numMeshIdx)];
+    for (uint32_t i = 0; i != numMeshIdx; i++)
+      idx[i] = oldToNew[mesh.vertexOffset + idx[i]] - newOffset;
+    mesh.vertexOffset = newOffset;
+  }
+
+  // 3) the merged mesh goes last, its vertices in the order of the first use
+  const uint64_t mergedOffset = vertexData.size() / stride;
+
+  vertexData.resize(vertexData.size() + size_t(numLocalVertices) * stride);
+
+  for (uint32_t v = 0; v != numLocalVertices; v++)
+    memcpy(vertexData.data() + (mergedOffset + fetchRemap[v]) * stride, md.vertexData.data() + size_t(localToGlobal[v]) * stride, stride);
+
+  memcpy(indices, localIndices.data(), numIndices * sizeof(uint32_t));
+
+  md.vertexData = std::move(vertexData);
+
+  merged.vertexOffset = mergedOffset;
+  merged.vertexCount  = numLocalVertices;
+  merged.indexSize    = getMeshIndexSize(merged, md.indexData);
+}
+
 void mergeNodesWithMaterial(Scene& scene, MeshData& meshData, const std::string& materialName)
 {
   // Find material index
@@ -85,17 +262,57 @@ void mergeNodesWithMaterial(Scene& scene, MeshData& meshData, const std::string&
   // Convert toDelete indices to mesh indices
   std::transform(toDelete.begin(), toDelete.end(), meshesToMerge.begin(), [&scene](uint32_t i) { return scene.meshForNode.at(i); });
 
+  // several nodes can share a mesh (see convertMeshFile()), merge each mesh once
+  std::sort(meshesToMerge.begin(), meshesToMerge.end());
+  meshesToMerge.erase(std::unique(meshesToMerge.begin(), meshesToMerge.end()), meshesToMerge.end());
+
   // TODO: if merged mesh transforms are non-zero, then we should pre-transform individual mesh vertices in meshData using local transform
+  // (batchStaticNodes() does that)
 
   // old-to-new mesh indices
   std::unordered_map<uint32_t, uint32_t> oldToNew;
 
+  // keep the boxes in sync with the meshes: the merged mesh gets the combined box
+  const bool hasBoxes  = meshData.boxes.size() == meshData.meshes.size();
+  const bool hasBounds = meshData.hasBounds();
+
+  BoundingBox mergedBox;
+
+  if (hasBoxes) {
+    std::vector<BoundingBox> boxes;
+    boxes.reserve(meshesToMerge.size());
+    for (uint32_t i : meshesToMerge)
+      boxes.push_back(meshData.boxes[i]);
+    mergedBox = combineBoxes(boxes);
+  }
+
+  if (hasQuantizedPositions(meshData.streams)) {
+    LVK_ASSERT(hasBoxes);
+    requantizeMeshes(meshData, meshesToMerge, mergedBox);
+  }
+
   // now move all the meshesToMerge to the end of array
   mergeIndexArray(meshData, meshesToMerge, oldToNew);
 
   // cutoff all but one of the merged meshes (insert the last saved mesh from meshesToMerge - they are all the same)
   eraseSelected(meshData.meshes, meshesToMerge);
 
+  if (hasBoxes) {
+    meshData.boxes.push_back(mergedBox);
+    eraseSelected(meshData.boxes, meshesToMerge);
+  }
+
+  optimizeMergedMesh(meshData, (uint32_t)meshData.meshes.size() - 1);
+
+  // only the merged mesh needs new bounds, the ones of all other meshes are still valid
+  if (hasBounds) {
+    meshData.spheres.emplace_back();
+    meshData.lodBoxes.emplace_back();
+    eraseSelected(meshData.spheres, meshesToMerge);
+    eraseSelected(meshData.lodBoxes, meshesToMerge);
+    recalculateBoundingBoxes(meshData, (uint32_t)meshData.meshes.size() - 1);
+  }
+
   for (auto& n : scene.meshForNode)
     n.second = oldToNew[n.second];
 
@@ -107,6 +324,321 @@ void mergeNodesWithMaterial(Scene& scene, MeshData& meshData, const std::string&
   deleteSceneNodes(scene, toDelete);
 }
 
+namespace
+{
+struct VertexRange {
+  uint32_t first = 0;
+  uint32_t count = 0;
+};
+} // namespace
+
+// all the vertices referenced by any LOD of the mesh (relative to its vertexOffset)
+static VertexRange getMeshVertexRange(const MeshData& md, const Mesh& mesh)
+{
+  const uint32_t numIndices = mesh.lodOffset[mesh.lodCount] - mesh.lodOffset[0];
+
+  if (!numIndices)
+    return {};
+
+  const uint32_t* indices     = md.indexData.data() + mesh.indexOffset;
+  const auto [minIdx, maxIdx] = std::minmax_element(indices, indices + numIndices);
+
+  return { .first = *minIdx, .count = *maxIdx - *minIdx + 1 };
+}
+
+// re-encode the normal of a vertex (see convertAIMesh() for the vertex formats)
+static void transformNormal(const lvk::VertexInput& streams, uint8_t* vertex, const glm::mat3& normalMatrix)
+{
+  uint8_t* attr = vertex + streams.attributes[2].offset;
+
+  uint32_t packed = 0;
+  memcpy(&packed, attr, sizeof(packed));
+
+  auto transform = [&normalMatrix](const vec3& n) {
+    const vec3 t = normalMatrix * n;
+    return glm::dot(t, t) > 0.0f ? glm::normalize(t) : t;
+  };
+
+  switch (streams.attributes[2].format) {
+  case lvk::VertexFormat_Int_2_10_10_10_REV:
+    packed = glm::packSnorm3x10_1x2(vec4(transform(vec3(glm::unpackSnorm3x10_1x2(packed))), 0.0f));
+    break;
+  case lvk::VertexFormat_Short2Norm:
+    packed = encodeOctahedralNormal(transform(decodeOctahedralNormal(packed)));
+    break;
+  default:
+    LVK_ASSERT_MSG(false, "Unsupported normal format");
+    return;
+  }
+
+  memcpy(attr, &packed, sizeof(packed));
+}
+
+uint32_t batchStaticNodes(Scene& scene, MeshData& meshData, const StaticBatchingParams& params)
+{
+  LVK_ASSERT(params.cellSize > 0.0f);
+
+  if (scene.hierarchy.empty() || meshData.meshes.empty())
+    return 0;
+
+  if (meshData.boxes.size() != meshData.meshes.size())
+    recalculateBoundingBoxes(meshData);
+
+  markAsChanged(scene, 0);
+  recalculateGlobalTransforms(scene);
+
+  // the batches are attached to the root node
+  const mat4 rootFromWorld = glm::inverse(scene.globalTransform[0]);
+
+  std::vector<uint32_t> numInstances(meshData.meshes.size());
+  for (const auto& [node, mesh] : scene.meshForNode)
+    numInstances[mesh]++;
+
+  // nothing in Scene tells which nodes are animated: all leaf nodes are treated as static
+  std::map<std::tuple<uint32_t, int, int, int>, std::vector<uint32_t>> groups; // (material, cell) -> nodes, in a deterministic order
+
+  for (uint32_t node = 1; node < scene.hierarchy.size(); node++) {
+    if (scene.hierarchy[node].firstChild != -1 || !scene.meshForNode.contains(node) || !scene.materialForNode.contains(node))
+      continue;
+
+    const uint32_t meshIndex  = scene.meshForNode.at(node);
+    const uint32_t numIndices = meshData.meshes[meshIndex].getLODIndicesCount(0);
+
+    if (!numIndices || numIndices > params.maxMeshIndices || numInstances[meshIndex] >= params.maxMeshInstances)
+      continue;
+
+    const vec3 cell = meshData.boxes[meshIndex].getTransformed(rootFromWorld * scene.globalTransform[node]).getCenter() / params.cellSize;
+
+    groups[{ scene.materialForNode.at(node), (int)floorf(cell.x), (int)floorf(cell.y), (int)floorf(cell.z) }].push_back(node);
+  }
+
+  struct Batch {
+    uint32_t material = 0;
+    std::vector<uint32_t> nodes;
+  };
+
+  std::vector<Batch> batches;
+
+  for (const auto& [key, nodes] : groups) {
+    Batch batch         = { .material = std::get<0>(key) };
+    uint32_t numIndices = 0;
+
+    auto flush = [&batches, &batch, &numIndices, &params]() {
+      if (batch.nodes.size() >= params.minBatchNodes)
+        batches.push_back(batch);
+      batch.nodes.clear();
+      numIndices = 0;
+    };
+
+    for (uint32_t node : nodes) {
+      const Mesh& mesh = meshData.meshes[scene.meshForNode.at(node)];
+      const uint32_t n = mesh.lodOffset[mesh.lodCount] - mesh.lodOffset[0];
+      if (!batch.nodes.empty() && numIndices + n > params.maxBatchIndices)
+        flush();
+      batch.nodes.push_back(node);
+      numIndices += n;
+    }
+
+    flush();
+  }
+
+  if (batches.empty())
+    return 0;
+
+  std::vector<bool> isBatched(scene.hierarchy.size(), false);
+  std::vector<uint32_t> batchedNodes;
+
+  for (const Batch& b : batches) {
+    for (uint32_t node : b.nodes) {
+      isBatched[node] = true;
+      batchedNodes.push_back(node);
+    }
+  }
+
+  std::sort(batchedNodes.begin(), batchedNodes.end());
+
+  std::vector<bool> keepMesh(meshData.meshes.size(), false);
+  for (const auto& [node, mesh] : scene.meshForNode)
+    if (!isBatched[node])
+      keepMesh[mesh] = true;
+
+  const bool isQuantized = hasQuantizedPositions(meshData.streams);
+  const bool hasBounds   = meshData.hasBounds();
+  const uint32_t stride  = meshData.streams.getVertexSize();
+
+  MeshData out;
+  out.streams = meshData.streams;
+
+  // 1) the meshes still used by other nodes are copied with their vertices, the ones used only by the batched nodes are dropped
+  std::vector<uint32_t> oldToNew(meshData.meshes.size(), ~0u);
+
+  for (size_t i = 0; i != meshData.meshes.size(); i++) {
+    if (!keepMesh[i])
+      continue;
+
+    const Mesh& mesh          = meshData.meshes[i];
+    const VertexRange range   = getMeshVertexRange(meshData, mesh);
+    const uint32_t numIndices = mesh.lodOffset[mesh.lodCount] - mesh.lodOffset[0];
+
+    Mesh m         = mesh;
+    m.indexOffset  = out.indexData.size();
+    m.vertexOffset = out.vertexData.size() / stride;
+    m.firstMeshlet = (uint32_t)out.meshlets.size();
+
+    for (uint32_t j = 0; j != numIndices; j++)
+      out.indexData.push_back(meshData.indexData[mesh.indexOffset + j] - range.first);
+
+    const uint8_t* vertices = meshData.vertexData.data() + (mesh.vertexOffset + range.first) * stride;
+    const Meshlet* meshlets = meshData.meshlets.data() + mesh.firstMeshlet;
+    out.vertexData.insert(out.vertexData.end(), vertices, vertices + size_t(range.count) * stride);
+    out.meshlets.insert(out.meshlets.end(), meshlets, meshlets + mesh.meshletCount);
+    out.boxes.push_back(meshData.boxes[i]);
+    if (hasBounds) {
+      out.spheres.push_back(meshData.spheres[i]);
+      out.lodBoxes.push_back(meshData.lodBoxes[i]);
+    }
+
+    oldToNew[i] = (uint32_t)out.meshes.size();
+    out.meshes.push_back(m);
+  }
+
+  const uint32_t firstBatchMesh = (uint32_t)out.meshes.size();
+
+  // 2) one mesh per batch: the vertices are transformed into the space of the root node, a batch has as many LODs as its most
+  // detailed source and the sources with shorter LOD chains contribute their last LOD to the remaining ones
+  for (const Batch& batch : batches) {
+    Mesh m = {
+      .lodCount     = 0,
+      .indexOffset  = out.indexData.size(),
+      .vertexOffset = out.vertexData.size() / stride,
+      .materialID   = batch.material,
+    };
+
+    struct Source {
+      const Mesh* mesh     = nullptr;
+      uint32_t firstVertex = 0; // first source vertex
+      uint32_t baseVertex  = 0; // where it goes in the batch
+      bool flipWinding     = false;
+    };
+
+    std::vector<Source> sources;
+    std::vector<vec3> positions;
+
+    sources.reserve(batch.nodes.size());
+
+    const size_t firstByte = out.vertexData.size();
+
+    for (uint32_t node : batch.nodes) {
+      const uint32_t meshIndex     = scene.meshForNode.at(node);
+      const Mesh& mesh             = meshData.meshes[meshIndex];
+      const VertexRange range      = getMeshVertexRange(meshData, mesh);
+      const mat4 t                 = rootFromWorld * scene.globalTransform[node];
+      const glm::mat3 t3           = glm::mat3(t);
+      const glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(t)));
+
+      sources.push_back({
+          .mesh        = &mesh,
+          .firstVertex = range.first,
+          .baseVertex  = (uint32_t)positions.size(),
+          // mirroring transforms flip the winding of all triangles, the batch node has no such transform to account for it
+          .flipWinding = glm::determinant(t3) < 0.0f,
+      });
+
+      // simplification errors are in object space
+      const float scale = std::max(glm::length(t3[0]), std::max(glm::length(t3[1]), glm::length(t3[2])));
+
+      m.lodCount = std::max(m.lodCount, std::min(mesh.lodCount, kMaxLODs));
+      for (uint32_t l = 0; l != kMaxLODs; l++)
+        m.lodError[l] = std::max(m.lodError[l], mesh.lodError[std::min(l, mesh.lodCount - 1)] * scale);
+
+      const size_t dstOffset  = out.vertexData.size();
+      const uint8_t* vertices = meshData.vertexData.data() + (mesh.vertexOffset + range.first) * stride;
+      out.vertexData.insert(out.vertexData.end(), vertices, vertices + size_t(range.count) * stride);
+
+      for (uint32_t v = 0; v != range.count; v++) {
+        uint8_t* vertex = out.vertexData.data() + dstOffset + size_t(v) * stride;
+        vec3 p;
+        if (isQuantized) {
+          uint16_t q[4];
+          memcpy(q, vertex, sizeof(q));
+          p = dequantizePosition(q, meshData.boxes[meshIndex]);
+        } else {
+          memcpy(&p, vertex, sizeof(p));
+        }
+        positions.push_back(vec3(t * vec4(p, 1.0f)));
+        transformNormal(out.streams, vertex, normalMatrix);
+      }
+    }
+
+    const BoundingBox box(positions.data(), positions.size());
+
+    for (size_t v = 0; v != positions.size(); v++) {
+      uint8_t* vertex = out.vertexData.data() + firstByte + v * stride;
+      if (isQuantized) {
+        uint16_t q[4];
+        quantizePosition(positions[v], box, q);
+        memcpy(vertex, q, sizeof(q));
+      } else {
+        memcpy(vertex, &positions[v], sizeof(vec3));
+      }
+    }
+
+    uint32_t numIndices = 0;
+
+    for (uint32_t l = 0; l != m.lodCount; l++) {
+      m.lodOffset[l] = numIndices;
+      for (const Source& s : sources) {
+        const uint32_t lod      = std::min(l, s.mesh->lodCount - 1);
+        const uint32_t* indices = meshData.indexData.data() + s.mesh->getLODFirstIndex(lod);
+        const uint32_t count    = s.mesh->getLODIndicesCount(lod);
+        for (uint32_t i = 0; i != count; i++)
+          out.indexData.push_back(indices[i] - s.firstVertex + s.baseVertex);
+        if (s.flipWinding) {
+          for (size_t i = out.indexData.size() - count; i != out.indexData.size(); i += 3)
+            std::swap(out.indexData[i + 1], out.indexData[i + 2]);
+        }
+        numIndices += count;
+      }
+    }
+
+    m.lodOffset[m.lodCount] = numIndices;
+    m.vertexCount           = (uint32_t)positions.size();
+    m.indexSize             = getMeshIndexSize(m, out.indexData);
+
+    out.boxes.push_back(box);
+    out.meshes.push_back(m);
+
+    if (hasBounds) {
+      out.spheres.emplace_back();
+      out.lodBoxes.emplace_back();
+      recalculateBoundingBoxes(out, (uint32_t)out.meshes.size() - 1);
+    }
+  }
+
+  out.materials    = std::move(meshData.materials);
+  out.textureFiles = std::move(meshData.textureFiles);
+
+  meshData = std::move(out);
+
+  // 3) replace the batched nodes
+  for (auto& [node, mesh] : scene.meshForNode)
+    mesh = isBatched[node] ? 0 : oldToNew[mesh];
+
+  for (size_t b = 0; b != batches.size(); b++) {
+    const int node              = addNode(scene, 0, 1);
+    scene.globalTransform[node] = scene.globalTransform[0];
+    scene.meshForNode[node]     = firstBatchMesh + (uint32_t)b;
+    scene.materialForNode[node] = batches[b].material;
+    setNodeName(scene, node, "StaticBatch" + std::to_string(b));
+  }
+
+  deleteSceneNodes(scene, batchedNodes);
+
+  printf("Static batching: %u nodes merged into %u batches\n", (uint32_t)batchedNodes.size(), (uint32_t)batches.size());
+
+  return (uint32_t)batches.size();
+}
+
 void mergeMaterialLists(
     const std::vector<std::vector<Material>*>& oldMaterials, const std::vector<std::vector<std::string>*>& oldTextures,
     std::vector<Material>& allMaterials, std::vector<std::string>& newTextures)
@@ -115,7 +647,7 @@ void mergeMaterialLists(
   std::unordered_map<std::string, int> newTextureNames;
   std::unordered_map<size_t, size_t> materialToTextureList; // use the index of Material in the allMaterials array
 
-  // create a combined material list [no hashing of materials, just straightforward merging of all lists]
+  // create a combined material list [duplicates are collapsed later, see deduplicateMaterials()]
   for (size_t midx = 0; midx != oldMaterials.size(); midx++) {
     for (const Material& m : *oldMaterials[midx]) {
       allMaterials.push_back(m);
@@ -149,3 +681,68 @@ void mergeMaterialLists(
     replaceTexture(i, &m.opacityTexture);
   }
 }
+
+uint32_t deduplicateMaterials(Scene& scene, MeshData& meshData)
+{
+  std::vector<Material>& materials = meshData.materials;
+
+  // Material has no padding, so equal contents mean equal bytes
+  static_assert(sizeof(Material) == 2 * sizeof(vec4) + 4 * sizeof(float) + 4 * sizeof(int) + sizeof(uint32_t));
+
+  std::unordered_multimap<uint64_t, uint32_t> hashToMaterial;
+  std::vector<uint32_t> oldToNew(materials.size());
+  std::vector<Material> uniqueMaterials;
+
+  uniqueMaterials.reserve(materials.size());
+
+  const bool hasNames = scene.materialNames.size() == materials.size();
+
+  std::vector<std::string> uniqueNames;
+
+  for (size_t i = 0; i != materials.size(); i++) {
+    const uint64_t hash = hash64(&materials[i], sizeof(Material));
+
+    // the first material with the same contents (and its name) is kept
+    uint32_t newIdx       = (uint32_t)uniqueMaterials.size();
+    const auto [beg, end] = hashToMaterial.equal_range(hash);
+    for (auto it = beg; it != end; it++) {
+      if (!memcmp(&uniqueMaterials[it->second], &materials[i], sizeof(Material))) {
+        newIdx = it->second;
+        break;
+      }
+    }
+
+    if (newIdx == uniqueMaterials.size()) {
+      hashToMaterial.emplace(hash, newIdx);
+      uniqueMaterials.push_back(materials[i]);
+      if (hasNames)
+        uniqueNames.push_back(scene.materialNames[i]);
+    }
+
+    oldToNew[i] = newIdx;
+  }
+
+  const uint32_t numRemoved = uint32_t(materials.size() - uniqueMaterials.size());
+
+  if (!numRemoved)
+    return 0;
+
+  for (Mesh& m : meshData.meshes) {
+    if (m.materialID < oldToNew.size())
+      m.materialID = oldToNew[m.materialID];
+  }
+
+  for (auto& [node, material] : scene.materialForNode) {
+    if (material < oldToNew.size())
+      material = oldToNew[material];
+  }
+
+  materials = std::move(uniqueMaterials);
+
+  if (hasNames)
+    scene.materialNames = std::move(uniqueNames);
+
+  printf("Materials: %u duplicates removed, %u unique materials left\n", numRemoved, (uint32_t)materials.size());
+
+  return numRemoved;
+}
@@ -5,6 +5,27 @@
 
 void mergeNodesWithMaterial(Scene& scene, MeshData& meshData, const std::string& materialName);
 
+// Heuristics of batchStaticNodes(): fewer draws vs. finer culling
+struct StaticBatchingParams {
+  // only nodes in the same cell of this uniform grid (in the space of the root node) are batched together:
+  // larger cells save more draws, smaller cells keep the batches small enough to be culled
+  float cellSize = 10.0f;
+  // meshes with more LOD0 indices are large enough to be drawn on their own
+  uint32_t maxMeshIndices = 8192;
+  // meshes used by this many nodes and more are left to instancing (see convertMeshFile())
+  uint32_t maxMeshInstances = 4;
+  // a cell is split into several batches when it has more indices (all LODs)
+  uint32_t maxBatchIndices = 1u << 20;
+  // fewer nodes are not worth a batch
+  uint32_t minBatchNodes = 2;
+};
+
+// Merge the meshes of static leaf nodes sharing a material and a grid cell into one mesh per batch. The vertices are
+// pre-transformed into the space of the root node and every batch is drawn by a new child of the root, which replaces the
+// merged nodes. LOD chains are kept, meshlets of the batches have to be rebuilt (see buildMeshlets()).
+// Returns the number of batches.
+uint32_t batchStaticNodes(Scene& scene, MeshData& meshData, const StaticBatchingParams& params = {});
+
 // Merge material lists from multiple scenes (follows the logic of merging in mergeScenes)
 void mergeMaterialLists(
     // Input:
@@ -14,3 +35,8 @@ void mergeMaterialLists(
     std::vector<Material>& allMaterials,
     std::vector<std::string>& newTextures // all textures (merged from oldTextures, only unique items)
 );
+
+// Collapse materials with identical contents (call after mergeMaterialLists(), once the textures are remapped) and remap
+// Mesh::materialID and Scene::materialForNode. The material names of the scene are compacted the same way, the first name
+// of every group of duplicates is kept. Returns the number of removed materials.
+uint32_t deduplicateMaterials(Scene& scene, MeshData& meshData);
@@ -0,0 +1,174 @@
+#include "shared/Scene/MeshStats.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <string>
+
+#include <meshoptimizer.h>
+
+#include <taskflow/taskflow.hpp>
+#include <taskflow/algorithm/for_each.hpp>
+
+static MeshStats analyzeMesh(const MeshData& m, uint32_t meshIndex)
+{
+  const Mesh& mesh          = m.meshes[meshIndex];
+  const uint32_t numIndices = mesh.getLODIndicesCount(0);
+
+  if (!numIndices)
+    return {};
+
+  const bool isQuantized = hasQuantizedPositions(m.streams);
+  const uint32_t stride  = m.streams.getVertexSize();
+
+  // merged meshes do not start at their vertexOffset (see mergeIndexArray())
+  const uint32_t* src         = m.indexData.data() + mesh.getLODFirstIndex(0);
+  const auto [minIdx, maxIdx] = std::minmax_element(src, src + numIndices);
+  const uint32_t firstVertex  = *minIdx;
+  const uint32_t numVertices  = *maxIdx - *minIdx + 1;
+  const uint8_t* vertices     = m.vertexData.data() + (mesh.vertexOffset + firstVertex) * stride;
+
+  std::vector<uint32_t> indices(numIndices);
+  for (uint32_t i = 0; i != numIndices; i++)
+    indices[i] = src[i] - firstVertex;
+
+  std::vector<vec3> positions(numVertices);
+  for (uint32_t v = 0; v != numVertices; v++) {
+    if (isQuantized) {
+      uint16_t q[4];
+      memcpy(q, vertices + size_t(v) * stride, sizeof(q));
+      positions[v] = dequantizePosition(q, m.boxes[meshIndex]);
+    } else {
+      memcpy(&positions[v], vertices + size_t(v) * stride, sizeof(vec3));
+    }
+  }
+
+  const meshopt_VertexCacheStatistics cache =
+      meshopt_analyzeVertexCache(indices.data(), numIndices, numVertices, kMeshStatsCacheSize, 0, 0);
+  const meshopt_OverdrawStatistics overdraw =
+      meshopt_analyzeOverdraw(indices.data(), numIndices, &positions[0].x, numVertices, sizeof(vec3));
+  const meshopt_VertexFetchStatistics fetch = meshopt_analyzeVertexFetch(indices.data(), numIndices, numVertices, stride);
+
+  return MeshStats{
+    .triangles           = numIndices / 3,
+    .vertices            = numVertices,
+    .verticesTransformed = cache.vertices_transformed,
+    .pixelsCovered       = overdraw.pixels_covered,
+    .pixelsShaded        = overdraw.pixels_shaded,
+    .bytesFetched        = fetch.bytes_fetched,
+    .vertexBytes         = uint64_t(numVertices) * stride,
+  };
+}
+
+MeshDataStats analyzeMeshData(const MeshData& m)
+{
+  LVK_PROFILER_FUNCTION();
+
+  MeshDataStats stats;
+
+  stats.meshes.resize(m.meshes.size());
+
+  tf::Taskflow taskflow;
+
+  taskflow.for_each_index(0u, (uint32_t)m.meshes.size(), 1u, [&m, &stats](uint32_t i) { stats.meshes[i] = analyzeMesh(m, i); });
+
+  runTaskflow(taskflow);
+
+  for (const MeshStats& s : stats.meshes)
+    stats.total.add(s);
+
+  return stats;
+}
+
+static void writeMeshStats(FILE* f, const MeshStats& s)
+{
+  fprintf(
+      f, "{ \"triangles\": %llu, \"vertices\": %llu, \"acmr\": %.4f, \"atvr\": %.4f, \"overdraw\": %.4f, \"overfetch\": %.4f }",
+      (unsigned long long)s.triangles, (unsigned long long)s.vertices, s.getACMR(), s.getATVR(), s.getOverdraw(), s.getOverfetch());
+}
+
+bool saveMeshStats(const char* fileName, const MeshDataStats& stats)
+{
+  FILE* f = fopen(fileName, "w");
+
+  if (!f) {
+    printf("Cannot write mesh stats to '%s'\n", fileName);
+    return false;
+  }
+
+  fprintf(f, "{\n  \"version\": %u,\n  \"cacheSize\": %u,\n  \"total\": ", kMeshStatsVersion, kMeshStatsCacheSize);
+  writeMeshStats(f, stats.total);
+  fprintf(f, ",\n  \"meshes\": [");
+  for (size_t i = 0; i != stats.meshes.size(); i++) {
+    fprintf(f, i ? ",\n    " : "\n    ");
+    writeMeshStats(f, stats.meshes[i]);
+  }
+  fprintf(f, "\n  ]\n}\n");
+
+  fclose(f);
+
+  return true;
+}
+
+// the first number stored as "key" after 'from' (only the files written by saveMeshStats() are expected)
+static bool findJSONNumber(const std::string& json, size_t from, const char* key, double& value)
+{
+  const std::string name = std::string("\"") + key + "\":";
+  const size_t pos       = json.find(name, from);
+
+  if (pos == std::string::npos)
+    return false;
+
+  value = strtod(json.c_str() + pos + name.size(), nullptr);
+
+  return true;
+}
+
+bool checkMeshStats(const char* baselineFileName, const MeshDataStats& stats, bool createMissingBaseline, float maxRegression)
+{
+  std::string json;
+
+  if (FILE* f = fopen(baselineFileName, "rb")) {
+    fseek(f, 0, SEEK_END);
+    json.resize(ftell(f));
+    fseek(f, 0, SEEK_SET);
+    json.resize(fread(json.data(), 1, json.size(), f));
+    fclose(f);
+  }
+
+  double version   = 0;
+  double cacheSize = 0;
+  double acmr      = 0;
+  double atvr      = 0;
+
+  const size_t total = json.find("\"total\"");
+
+  const bool isValid = findJSONNumber(json, 0, "version", version) && version == kMeshStatsVersion &&
+                       findJSONNumber(json, 0, "cacheSize", cacheSize) && cacheSize == kMeshStatsCacheSize &&
+                       total != std::string::npos && findJSONNumber(json, total, "acmr", acmr) &&
+                       findJSONNumber(json, total, "atvr", atvr);
+
+  if (!isValid && !createMissingBaseline) {
+    printf("No valid mesh stats baseline found in '%s' (save the current stats there to accept them)\n", baselineFileName);
+    return false;
+  }
+
+  if (!isValid) {
+    printf("No valid mesh stats baseline found, saving the current stats to '%s'\n", baselineFileName);
+    return saveMeshStats(baselineFileName, stats);
+  }
+
+  const float newACMR = stats.total.getACMR();
+  const float newATVR = stats.total.getATVR();
+
+  printf("Mesh stats: ACMR %.4f (baseline %.4f), ATVR %.4f (baseline %.4f)\n", newACMR, acmr, newATVR, atvr);
+
+  // the baseline is rounded to 4 digits
+  const double tolerance = 1.0 + maxRegression;
+
+  if (newACMR > acmr * tolerance + 0.0001 || newATVR > atvr * tolerance + 0.0001) {
+    printf("Mesh optimization quality regressed by more than %.1f%% against '%s'\n", maxRegression * 100.0f, baselineFileName);
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "shared/Scene/VtxData.h"
+
+// Size of the simulated post-transform cache (see meshopt_analyzeVertexCache())
+constexpr const uint32_t kMeshStatsCacheSize = 16;
+
+// Identify the JSON layout written by saveMeshStats()
+constexpr const uint32_t kMeshStatsVersion = 1;
+
+// How cache- and fetch-friendly the LOD0 of a mesh is, as simulated by meshoptimizer. The raw counters are kept, so the
+// stats of several meshes can be added up. Lower ratios are better.
+struct MeshStats {
+  uint64_t triangles           = 0;
+  uint64_t vertices            = 0; // all the vertices in the range referenced by LOD0
+  uint64_t verticesTransformed = 0; // post-transform cache misses
+  uint64_t pixelsCovered       = 0;
+  uint64_t pixelsShaded        = 0;
+  uint64_t bytesFetched        = 0; // pre-transform cache (vertex fetch) traffic
+  uint64_t vertexBytes         = 0;
+
+  // average cache miss ratio: transformed vertices per triangle (0.5 is the ideal for a regular grid, 3 is the worst)
+  float getACMR() const { return triangles ? float(verticesTransformed) / float(triangles) : 0.0f; }
+  // average transformed vertex ratio: transformed vertices per vertex (1 is ideal)
+  float getATVR() const { return vertices ? float(verticesTransformed) / float(vertices) : 0.0f; }
+  // shaded pixels per covered pixel (1 is ideal)
+  float getOverdraw() const { return pixelsCovered ? float(pixelsShaded) / float(pixelsCovered) : 0.0f; }
+  // fetched bytes per vertex data byte (1 is ideal)
+  float getOverfetch() const { return vertexBytes ? float(bytesFetched) / float(vertexBytes) : 0.0f; }
+
+  void add(const MeshStats& s)
+  {
+    triangles += s.triangles;
+    vertices += s.vertices;
+    verticesTransformed += s.verticesTransformed;
+    pixelsCovered += s.pixelsCovered;
+    pixelsShaded += s.pixelsShaded;
+    bytesFetched += s.bytesFetched;
+    vertexBytes += s.vertexBytes;
+  }
+};
+
+struct MeshDataStats {
+  MeshStats total; // all meshes combined
+  std::vector<MeshStats> meshes;
+};
+
+// analyze LOD0 of all meshes (in parallel)
+MeshDataStats analyzeMeshData(const MeshData& m);
+
+// write the stats as JSON (the totals and every mesh)
+bool saveMeshStats(const char* fileName, const MeshDataStats& stats);
+
+// Compare the totals against a baseline written by saveMeshStats(). Returns false if ACMR or ATVR grew by more than
+// 'maxRegression' (relative). A missing baseline is created from 'stats' if 'createMissingBaseline' is set, otherwise it is
+// a failure.
+bool checkMeshStats(
+    const char* baselineFileName, const MeshDataStats& stats, bool createMissingBaseline = true, float maxRegression = 0.02f);
@@ -1,9 +1,14 @@
 ﻿#include "shared/Scene/Scene.h"
 #include "shared/Utils.h"
+#include "shared/UtilsMathSIMD.h"
 
 #include <algorithm>
+#include <assert.h>
 #include <numeric>
 
+#include <taskflow/taskflow.hpp>
+#include <taskflow/algorithm/for_each.hpp>
+
 int addNode(Scene& scene, int parent, int level)
 {
   const int node = (int)scene.hierarchy.size();
@@ -33,17 +38,52 @@ int addNode(Scene& scene, int parent, int level)
   scene.hierarchy[node].level       = level;
   scene.hierarchy[node].nextSibling = -1;
   scene.hierarchy[node].firstChild  = -1;
+
+  // the subtrees of changed nodes are kept complete (see markAsChanged())
+  if (parent > -1 && parent < (int)scene.changedEpoch.size() && scene.changedEpoch[parent] == scene.dirtyEpoch)
+    markAsChanged(scene, node);
+
   return node;
 }
 
 void markAsChanged(Scene& scene, int node)
 {
-  const int level = scene.hierarchy[node].level;
-  scene.changedAtThisFrame[level].push_back(node);
+  std::vector<uint32_t>& epochs = scene.changedEpoch;
+
+  if (epochs.size() < scene.hierarchy.size())
+    epochs.resize(scene.hierarchy.size(), 0);
+
+  // a node is always marked together with its whole subtree, so a marked node means a marked subtree
+  if (epochs[node] == scene.dirtyEpoch)
+    return;
+
+  std::vector<int> stack; // not touched for leaf nodes
+
+  for (int n = node;;) {
+    epochs[n] = scene.dirtyEpoch;
+    scene.changedNodes.push_back(n);
+
+    for (int s = scene.hierarchy[n].firstChild; s != -1; s = scene.hierarchy[s].nextSibling) {
+      if (epochs[s] != scene.dirtyEpoch)
+        stack.push_back(s);
+    }
+
+    if (stack.empty())
+      break;
+
+    n = stack.back();
+    stack.pop_back();
+  }
+}
+
+static void clearChangedNodes(Scene& scene)
+{
+  scene.changedNodes.clear();
 
-  // TODO: use non-recursive iteration with aux stack
-  for (int s = scene.hierarchy[node].firstChild; s != -1; s = scene.hierarchy[s].nextSibling) {
-    markAsChanged(scene, s);
+  // the epochs of all the nodes are cleared only once the counter wraps around
+  if (++scene.dirtyEpoch == 0) {
+    std::fill(scene.changedEpoch.begin(), scene.changedEpoch.end(), 0);
+    scene.dirtyEpoch = 1;
   }
 }
 
@@ -66,31 +106,123 @@ int findNodeByName(const Scene& scene, const std::string& name)
 bool mat4IsIdentity(const glm::mat4& m);
 void fprintfMat4(FILE* f, const glm::mat4& m);
 
+// Counting sort by level: every parent goes before its children, however deep the hierarchy is. The nodes of level 'l'
+// end up in [levelStart[l]...levelStart[l+1]).
+static void sortChangedNodesByLevel(const Scene& scene, std::vector<int>& sortedNodes, std::vector<uint32_t>& levelStart)
+{
+  const size_t numChanged = scene.changedNodes.size();
+
+  std::vector<uint32_t> levels(numChanged);
+
+  levelStart.assign(1, 0);
+
+  for (size_t i = 0; i != numChanged; i++) {
+    const uint32_t level = (uint32_t)scene.hierarchy[scene.changedNodes[i]].level;
+    if (level + 1 >= levelStart.size())
+      levelStart.resize(level + 2, 0);
+    levelStart[level + 1]++;
+    levels[i] = level;
+  }
+
+  for (size_t l = 1; l < levelStart.size(); l++)
+    levelStart[l] += levelStart[l - 1];
+
+  std::vector<uint32_t> pos(levelStart);
+
+  sortedNodes.resize(numChanged);
+
+  for (size_t i = 0; i != numChanged; i++)
+    sortedNodes[pos[levels[i]]++] = scene.changedNodes[i];
+}
+
+static void updateGlobalTransforms(Scene& scene, const int* nodes, uint32_t numNodes)
+{
+  for (uint32_t i = 0; i != numNodes; i++) {
+    const int c = nodes[i];
+    const int p = scene.hierarchy[c].parent;
+    if (p > -1)
+      multiplyAffine(scene.globalTransform[p], scene.localTransform[c], scene.globalTransform[c]);
+    else
+      scene.globalTransform[c] = scene.localTransform[c];
+  }
+}
+
 // CPU version of global transform update []
 bool recalculateGlobalTransforms(Scene& scene)
 {
-  bool wasUpdated = false;
+  if (scene.changedNodes.empty())
+    return false;
 
-  if (!scene.changedAtThisFrame[0].empty()) {
-    const int c              = scene.changedAtThisFrame[0][0];
-    scene.globalTransform[c] = scene.localTransform[c];
-    scene.changedAtThisFrame[0].clear();
-    wasUpdated = true;
-  }
+  std::vector<int> sortedNodes;
+  std::vector<uint32_t> levelStart;
 
-  for (int i = 1; i < MAX_NODE_LEVEL; i++) {
-    for (int c : scene.changedAtThisFrame[i]) {
-      const int p              = scene.hierarchy[c].parent;
-      scene.globalTransform[c] = scene.globalTransform[p] * scene.localTransform[c];
-    }
-    wasUpdated |= !scene.changedAtThisFrame[i].empty();
-    scene.changedAtThisFrame[i].clear();
+  sortChangedNodesByLevel(scene, sortedNodes, levelStart);
+
+  // one linear pass over all the changed nodes
+  updateGlobalTransforms(scene, sortedNodes.data(), (uint32_t)sortedNodes.size());
+
+  clearChangedNodes(scene);
+
+  return true;
+}
+
+bool recalculateGlobalTransforms(Scene& scene, tf::Executor& executor)
+{
+  if (scene.changedNodes.size() < kTransformsParallelMinNodes)
+    return recalculateGlobalTransforms(scene);
+
+  std::vector<int> sortedNodes;
+  std::vector<uint32_t> levelStart;
+
+  sortChangedNodesByLevel(scene, sortedNodes, levelStart);
+
+  const int* nodes = sortedNodes.data();
+
+  // the levels are processed one after another: large levels are split into chunks, runs of small levels go into one serial task
+  tf::Taskflow taskflow;
+  tf::Task prevTask;
+
+  auto addTask = [&prevTask](tf::Task task) {
+    if (!prevTask.empty())
+      prevTask.precede(task);
+    prevTask = task;
+  };
+  auto addSerialTask = [&scene, &taskflow, &addTask, nodes](uint32_t begin, uint32_t end) {
+    if (begin != end)
+      addTask(taskflow.emplace([&scene, nodes, begin, end]() { updateGlobalTransforms(scene, nodes + begin, end - begin); }));
+  };
+
+  uint32_t serialBegin = 0;
+
+  for (size_t l = 0; l + 1 < levelStart.size(); l++) {
+    const uint32_t begin = levelStart[l];
+    const uint32_t end   = levelStart[l + 1];
+
+    if (end - begin < kTransformsParallelMinNodes)
+      continue;
+
+    addSerialTask(serialBegin, begin);
+
+    const uint32_t numChunks = (end - begin + kTransformsParallelChunkSize - 1) / kTransformsParallelChunkSize;
+
+    addTask(taskflow.for_each_index(0u, numChunks, 1u, [&scene, nodes, begin, end](uint32_t i) {
+      const uint32_t first = begin + i * kTransformsParallelChunkSize;
+      updateGlobalTransforms(scene, nodes + first, std::min(kTransformsParallelChunkSize, end - first));
+    }));
+
+    serialBegin = end;
   }
 
-  return wasUpdated;
+  addSerialTask(serialBegin, (uint32_t)sortedNodes.size());
+
+  executor.run(taskflow).wait();
+
+  clearChangedNodes(scene);
+
+  return true;
 }
 
-void loadMap(FILE* f, std::unordered_map<uint32_t, uint32_t>& map)
+void loadMap(FILE* f, SparseSet& map)
 {
   std::vector<uint32_t> ms;
 
@@ -100,6 +232,9 @@ void loadMap(FILE* f, std::unordered_map<uint32_t, uint32_t>& map)
   ms.resize(sz);
   fread(ms.data(), sizeof(uint32_t), sz, f);
 
+  map.clear();
+  map.reserve(sz / 2);
+
   for (size_t i = 0; i < (sz / 2); i++)
     map[ms[i * 2 + 0]] = ms[i * 2 + 1];
 }
@@ -113,6 +248,12 @@ void loadScene(const char* fileName, Scene& scene)
     return;
   }
 
+  if (!readCacheFileHeader(f, kSceneFileMagic, kSceneFileVersion)) {
+    printf("Corrupted or outdated scene file '%s'.\n", fileName);
+    assert(false);
+    exit(EXIT_FAILURE);
+  }
+
   uint32_t sz = 0;
   fread(&sz, sizeof(sz), 1, f);
 
@@ -120,7 +261,6 @@ void loadScene(const char* fileName, Scene& scene)
   scene.globalTransform.resize(sz);
   scene.localTransform.resize(sz);
   // TODO: check > -1
-  // TODO: recalculate changedAtThisLevel() - find max depth of a node [or save scene.maxLevel]
   fread(scene.localTransform.data(), sizeof(glm::mat4), sz, f);
   fread(scene.globalTransform.data(), sizeof(glm::mat4), sz, f);
   fread(scene.hierarchy.data(), sizeof(Hierarchy), sz, f);
@@ -141,7 +281,7 @@ void loadScene(const char* fileName, Scene& scene)
   recalculateGlobalTransforms(scene);
 }
 
-void saveMap(FILE* f, const std::unordered_map<uint32_t, uint32_t>& map)
+void saveMap(FILE* f, const SparseSet& map)
 {
   std::vector<uint32_t> ms;
   ms.reserve(map.size() * 2);
@@ -154,9 +294,17 @@ void saveMap(FILE* f, const std::unordered_map<uint32_t, uint32_t>& map)
   fwrite(ms.data(), sizeof(uint32_t), ms.size(), f);
 }
 
-void saveScene(const char* fileName, const Scene& scene)
+void saveScene(const char* fileName, const Scene& scene, uint64_t sourcesStamp)
 {
-  FILE* f = fopen(fileName, "wb");
+  FILE* f = fopen(fileName, "w+b");
+
+  if (!f) {
+    printf("Error opening scene file '%s' for writing.\n", fileName);
+    assert(false);
+    exit(EXIT_FAILURE);
+  }
+
+  beginCacheFile(f);
 
   const uint32_t sz = (uint32_t)scene.hierarchy.size();
   fwrite(&sz, sizeof(sz), 1, f);
@@ -174,6 +322,9 @@ void saveScene(const char* fileName, const Scene& scene)
     saveStringList(f, scene.nodeNames);
     saveStringList(f, scene.materialNames);
   }
+
+  finishCacheFile(f, kSceneFileMagic, kSceneFileVersion, sourcesStamp);
+
   fclose(f);
 }
 
@@ -215,18 +366,13 @@ void dumpTransforms(const char* fileName, const Scene& scene)
 
 void printChangedNodes(const Scene& scene)
 {
-  for (int i = 0; i < MAX_NODE_LEVEL && (!scene.changedAtThisFrame[i].empty()); i++) {
-    printf("Changed at level(%d):\n", i);
-
-    for (const int& c : scene.changedAtThisFrame[i]) {
-      int p = scene.hierarchy[c].parent;
-      // scene.globalTransform_[c] = scene.globalTransform_[p] * scene.localTransform_[c];
-      printf(" Node %d. Parent = %d; LocalTransform: ", c, p);
-      fprintfMat4(stdout, scene.localTransform[i]);
-      if (p > -1) {
-        printf(" ParentGlobalTransform: ");
-        fprintfMat4(stdout, scene.globalTransform[p]);
-      }
+  for (int c : scene.changedNodes) {
+    int p = scene.hierarchy[c].parent;
+    printf(" Node %d. Level = %d; Parent = %d; LocalTransform: ", c, scene.hierarchy[c].level, p);
+    fprintfMat4(stdout, scene.localTransform[c]);
+    if (p > -1) {
+      printf(" ParentGlobalTransform: ");
+      fprintfMat4(stdout, scene.globalTransform[p]);
     }
   }
 }
@@ -258,11 +404,11 @@ void shiftNodes(Scene& scene, int startOffset, int nodeCount, int shiftAmount)
     shiftNode(scene.hierarchy[i + startOffset]);
 }
 
-using ItemMap = std::unordered_map<uint32_t, uint32_t>;
-
 // Add the items from otherMap shifting indices and values along the way
-void mergeMaps(ItemMap& m, const ItemMap& otherMap, int indexOffset, int itemOffset)
+void mergeMaps(SparseSet& m, const SparseSet& otherMap, int indexOffset, int itemOffset)
 {
+  m.reserve(m.size() + otherMap.size());
+
   for (const auto& i : otherMap)
     m[i.first + indexOffset] = i.second + itemOffset;
 }
@@ -417,15 +563,16 @@ int findLastNonDeletedItem(const Scene& scene, const std::vector<int>& newIndice
   return (newIndices[node] == -1) ? findLastNonDeletedItem(scene, newIndices, scene.hierarchy[node].nextSibling) : newIndices[node];
 }
 
-void shiftMapIndices(std::unordered_map<uint32_t, uint32_t>& items, const std::vector<int>& newIndices)
+void shiftMapIndices(SparseSet& items, const std::vector<int>& newIndices)
 {
-  std::unordered_map<uint32_t, uint32_t> newItems;
+  SparseSet newItems;
+  newItems.reserve(items.size());
   for (const auto& m : items) {
     int newIndex = newIndices[m.first];
     if (newIndex != -1)
       newItems[newIndex] = m.second;
   }
-  items = newItems;
+  items = std::move(newItems);
 }
 
 // Approximately an O ( N * Log(N) * Log(M)) algorithm (N = scene.size, M = nodesToDelete.size) to delete a collection of nodes from scene
@@ -457,6 +604,7 @@ void deleteSceneNodes(Scene& scene, const std::vector<uint32_t>& nodesToDelete)
       .firstChild  = findLastNonDeletedItem(scene, newIndices, h.firstChild),
       .nextSibling = findLastNonDeletedItem(scene, newIndices, h.nextSibling),
       .lastSibling = findLastNonDeletedItem(scene, newIndices, h.lastSibling),
+      .level       = h.level,
     };
   };
   std::transform(scene.hierarchy.begin(), scene.hierarchy.end(), scene.hierarchy.begin(), nodeMover);
@@ -470,7 +618,18 @@ void deleteSceneNodes(Scene& scene, const std::vector<uint32_t>& nodesToDelete)
   eraseSelected(scene.localTransform, indicesToDelete);
   eraseSelected(scene.globalTransform, indicesToDelete);
 
-  // 4b) All the maps should change the key values with the newIndices[] array
+  // 4b) All the maps should change the key values with the newIndices[] array (and so does the list of changed nodes)
+  for (int& c : scene.changedNodes)
+    c = newIndices[c];
+  std::erase(scene.changedNodes, -1);
+
+  std::vector<uint32_t> changedEpoch(nodes.size(), 0);
+  for (size_t i = 0; i < scene.changedEpoch.size(); i++) {
+    if (newIndices[i] != -1)
+      changedEpoch[newIndices[i]] = scene.changedEpoch[i];
+  }
+  scene.changedEpoch = std::move(changedEpoch);
+
   shiftMapIndices(scene.meshForNode, newIndices);
   shiftMapIndices(scene.materialForNode, newIndices);
   shiftMapIndices(scene.nameForNode, newIndices);
@@ -1,7 +1,9 @@
 ﻿#pragma once
 
+#include <assert.h>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <glm/glm.hpp>
@@ -9,9 +11,20 @@
 
 using glm::mat4;
 
+namespace tf {
+class Executor;
+}
+
 // we do not define std::vector<Node*> Children - this is already present in the aiNode from assimp
 
-constexpr const int MAX_NODE_LEVEL = 16;
+// Identify the scene file (.scene) and its layout version
+constexpr const uint32_t kSceneFileMagic   = 0x4E454353; // 'SCEN'
+constexpr const uint32_t kSceneFileVersion = 1;
+
+// The parallel recalculateGlobalTransforms() splits the dirty nodes of a level into chunks of this size. Levels with fewer
+// dirty nodes than kTransformsParallelMinNodes are not worth the synchronization and are updated serially.
+constexpr const uint32_t kTransformsParallelChunkSize = 1024;
+constexpr const uint32_t kTransformsParallelMinNodes  = 4096;
 
 struct Hierarchy {
   // parent for this node (or -1 for root)
@@ -26,29 +39,96 @@ struct Hierarchy {
   int level = 0;
 };
 
+// Sparse set of per-node values (a component). The (node, value) pairs are packed in one array, which is iterated contiguously
+// in the order of insertion (erase() moves the last pair into the hole), and 'slots_' maps every node to its pair. The nodes
+// must not be modified while iterating, use erase() and operator[] instead.
+class SparseSet
+{
+public:
+  using Item = std::pair<uint32_t, uint32_t>; // node, value
+
+  bool contains(uint32_t node) const { return node < slots_.size() && slots_[node] != kNoSlot; }
+  uint32_t& at(uint32_t node)
+  {
+    assert(contains(node));
+    return items_[slots_[node]].second;
+  }
+  uint32_t at(uint32_t node) const
+  {
+    assert(contains(node));
+    return items_[slots_[node]].second;
+  }
+  // inserts 0 if there is no value for the node yet
+  uint32_t& operator[](uint32_t node)
+  {
+    if (node >= slots_.size())
+      slots_.resize(node + 1, kNoSlot);
+    if (slots_[node] == kNoSlot) {
+      slots_[node] = (uint32_t)items_.size();
+      items_.push_back({ node, 0 });
+    }
+    return items_[slots_[node]].second;
+  }
+  bool erase(uint32_t node)
+  {
+    if (!contains(node))
+      return false;
+    const uint32_t slot        = slots_[node];
+    items_[slot]               = items_.back();
+    slots_[items_[slot].first] = slot;
+    slots_[node]               = kNoSlot;
+    items_.pop_back();
+    return true;
+  }
+  void clear()
+  {
+    items_.clear();
+    slots_.clear();
+  }
+  void reserve(size_t size) { items_.reserve(size); }
+  size_t size() const { return items_.size(); }
+  bool empty() const { return items_.empty(); }
+
+  std::vector<Item>::iterator begin() { return items_.begin(); }
+  std::vector<Item>::iterator end() { return items_.end(); }
+  std::vector<Item>::const_iterator begin() const { return items_.begin(); }
+  std::vector<Item>::const_iterator end() const { return items_.end(); }
+
+private:
+  static constexpr uint32_t kNoSlot = ~0u;
+
+  std::vector<Item> items_;
+  std::vector<uint32_t> slots_; // indexed by node
+};
+
 /* This scene is converted into a descriptorSet(s) in MultiRenderer class 
    This structure is also used as a storage type in SceneExporter tool
  */
 struct Scene {
-  // local transformations for each node and global transforms
+  // local transformations for each node and global transforms (both affine, see multiplyAffine())
   // + an array of 'dirty/changed' local transforms
   std::vector<mat4> localTransform;  // indexed by node
   std::vector<mat4> globalTransform; // indexed by node
 
-  // list of nodes that need their global transforms recalculated
-  std::vector<int> changedAtThisFrame[MAX_NODE_LEVEL];
+  // list of nodes that need their global transforms recalculated (in any order and of any depth, they are sorted by
+  // level in recalculateGlobalTransforms())
+  std::vector<int> changedNodes;
+  // every node goes into changedNodes once: it is there if changedEpoch[node] == dirtyEpoch, recalculateGlobalTransforms()
+  // advances dirtyEpoch instead of clearing the array
+  std::vector<uint32_t> changedEpoch; // indexed by node, grows on demand
+  uint32_t dirtyEpoch = 1;
 
   // Hierarchy component
   std::vector<Hierarchy> hierarchy;
 
   // Mesh component: which Mesh belongs to which node (Node -> Mesh)
-  std::unordered_map<uint32_t, uint32_t> meshForNode;
+  SparseSet meshForNode;
 
   // Material component: which material belongs to which node (Node -> Material)
-  std::unordered_map<uint32_t, uint32_t> materialForNode;
+  SparseSet materialForNode;
 
   // Node name component: which name is assigned to the node (Node -> Name)
-  std::unordered_map<uint32_t, uint32_t> nameForNode;
+  SparseSet nameForNode;
 
   // List of scene node names
   std::vector<std::string> nodeNames;
@@ -79,9 +159,12 @@ inline void setNodeName(Scene& scene, int node, const std::string& name)
 int getNodeLevel(const Scene& scene, int n);
 
 bool recalculateGlobalTransforms(Scene& scene);
+// the same, but the nodes of every level are updated in parallel
+bool recalculateGlobalTransforms(Scene& scene, tf::Executor& executor);
 
 void loadScene(const char* fileName, Scene& scene);
-void saveScene(const char* fileName, const Scene& scene);
+// 'sourcesStamp' is stored in the file to detect stale caches later (see getFilesStamp())
+void saveScene(const char* fileName, const Scene& scene, uint64_t sourcesStamp = 0);
 
 void dumpTransforms(const char* fileName, const Scene& scene);
 void printChangedNodes(const Scene& scene);
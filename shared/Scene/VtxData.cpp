@@ -1,11 +1,297 @@
 #include "shared/Scene/VtxData.h"
+#include "shared/Scene/Scene.h"
 
 #include <algorithm>
 #include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <map>
 #include <stdio.h>
 
-bool isMeshDataValid(const char* fileName)
+#include <meshoptimizer.h>
+
+#include <taskflow/taskflow.hpp>
+#include <taskflow/algorithm/for_each.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VTXDATA_SIMD_SSE 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define VTXDATA_SIMD_NEON 1
+#endif
+
+static uint64_t alignSectionOffset(uint64_t offset)
+{
+  return (offset + kMeshFileSectionAlignment - 1) & ~(kMeshFileSectionAlignment - 1);
+}
+
+// number of stored bounding spheres and LOD boxes
+static uint32_t getMeshFileBoundsCount(const MeshFileHeader& header)
+{
+  return (header.flags & MeshFileFlags_Bounds) ? header.meshCount : 0u;
+}
+
+// calculate aligned offsets of all the sections following the header and the vertex streams description
+static void layoutMeshFileSections(MeshFileHeader& header)
+{
+  header.meshesOffset     = alignSectionOffset(sizeof(MeshFileHeader) + sizeof(lvk::VertexInput));
+  header.boxesOffset      = alignSectionOffset(header.meshesOffset + sizeof(Mesh) * header.meshCount);
+  header.spheresOffset    = alignSectionOffset(header.boxesOffset + sizeof(BoundingBox) * header.meshCount);
+  header.lodBoxesOffset   = alignSectionOffset(header.spheresOffset + sizeof(BoundingSphere) * getMeshFileBoundsCount(header));
+  header.tocOffset        = alignSectionOffset(header.lodBoxesOffset + sizeof(MeshLODBoxes) * getMeshFileBoundsCount(header));
+  header.chunksOffset     = alignSectionOffset(header.tocOffset + sizeof(MeshFileTOCEntry) * header.meshCount);
+  header.meshletsOffset =
+      alignSectionOffset(header.chunksOffset + sizeof(MeshFileChunk) * (header.indexChunkCount + header.vertexChunkCount));
+  header.indexDataOffset  = alignSectionOffset(header.meshletsOffset + sizeof(Meshlet) * header.meshletCount);
+  header.vertexDataOffset = alignSectionOffset(header.indexDataOffset + header.storedIndexDataSize);
+}
+
+// check the header against the current layout and the actual file size
+static bool isMeshFileHeaderValid(const MeshFileHeader& header, uint64_t fileSize)
+{
+  if (header.magicValue != 0x12345678 || header.version != kMeshFileVersion)
+    return false;
+
+  MeshFileHeader expected = header;
+  layoutMeshFileSections(expected);
+
+  if (memcmp(&expected, &header, sizeof(header)))
+    return false;
+
+  if (header.flags & ~(MeshFileFlags_Compressed | MeshFileFlags_Bounds))
+    return false;
+
+  // uncompressed files store the index and vertex data as-is
+  if (!(header.flags & MeshFileFlags_Compressed) &&
+      (header.indexChunkCount || header.vertexChunkCount || header.storedIndexDataSize != header.indexDataSize ||
+       header.storedVertexDataSize != header.vertexDataSize))
+    return false;
+
+  return header.vertexDataOffset + header.storedVertexDataSize <= fileSize;
+}
+
+// split [0, count) into chunks starting at the given (unsorted) offsets; 'granularity' keeps index chunks made of whole triangles
+static std::vector<MeshFileChunk> makeMeshFileChunks(std::vector<uint64_t> starts, uint64_t count, uint32_t granularity)
+{
+  starts.push_back(0);
+  std::sort(starts.begin(), starts.end());
+  starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+
+  std::vector<MeshFileChunk> chunks;
+  chunks.reserve(starts.size());
+
+  for (size_t i = 0; i != starts.size(); i++) {
+    const uint64_t first = starts[i];
+    if (first >= count || first % granularity)
+      continue;
+    if (!chunks.empty())
+      chunks.back().count = first - chunks.back().first;
+    chunks.push_back({ .first = first });
+  }
+
+  if (!chunks.empty())
+    chunks.back().count = count - chunks.back().first;
+
+  return chunks;
+}
+
+// element ranges of indices and vertices used by every mesh and their hashes (byte ranges are filled in once the file layout is known)
+static std::vector<MeshFileTOCEntry> buildMeshFileTOC(const MeshData& m, uint32_t vertexSize)
+{
+  std::vector<MeshFileTOCEntry> toc(m.meshes.size());
+
+  for (size_t i = 0; i != m.meshes.size(); i++) {
+    const Mesh& mesh     = m.meshes[i];
+    MeshFileTOCEntry& e  = toc[i];
+    const uint64_t first = std::min<uint64_t>(mesh.indexOffset, m.indexData.size());
+
+    e.firstIndex = first;
+    e.indexCount = (uint32_t)std::min<uint64_t>(mesh.lodOffset[mesh.lodCount] - mesh.lodOffset[0], m.indexData.size() - first);
+
+    if (!e.indexCount) {
+      e.firstVertex = mesh.vertexOffset;
+      continue;
+    }
+
+    const auto [minIdx, maxIdx] =
+        std::minmax_element(m.indexData.begin() + e.firstIndex, m.indexData.begin() + e.firstIndex + e.indexCount);
+
+    e.firstVertex = mesh.vertexOffset + *minIdx;
+    e.vertexCount = *maxIdx - *minIdx + 1;
+
+    e.indexDataHash  = hash64(m.indexData.data() + e.firstIndex, size_t(e.indexCount) * sizeof(uint32_t));
+    e.vertexDataHash = hash64(m.vertexData.data() + size_t(e.firstVertex) * vertexSize, size_t(e.vertexCount) * vertexSize);
+  }
+
+  return toc;
+}
+
+// find chunks covering the elements [first, first + count)
+static void findMeshFileChunks(
+    const MeshFileChunk* chunks, uint32_t numChunks, uint64_t first, uint32_t count, uint32_t& firstChunk, uint32_t& chunkCount)
+{
+  firstChunk = 0;
+  chunkCount = 0;
+
+  if (!count || !numChunks)
+    return;
+
+  auto findChunk = [chunks, numChunks](uint64_t element) -> uint32_t {
+    const MeshFileChunk* c =
+        std::upper_bound(chunks, chunks + numChunks, element, [](uint64_t e, const MeshFileChunk& c) { return e < c.first; });
+    return c == chunks ? 0 : uint32_t(c - chunks - 1);
+  };
+
+  firstChunk = findChunk(first);
+  chunkCount = findChunk(first + count - 1) - firstChunk + 1;
+}
+
+// decode all the chunks in parallel; 'data' points to the stored index and vertex data located at 'dataOffset' in the file
+static bool decodeMeshFileChunks(
+    const MeshFileHeader& header, const MeshFileChunk* chunks, const uint8_t* data, uint64_t dataOffset, uint32_t vertexSize,
+    uint32_t* indexData, uint8_t* vertexData)
+{
+  LVK_PROFILER_FUNCTION();
+
+  const uint64_t numIndices  = header.indexDataSize / sizeof(uint32_t);
+  const uint64_t numVertices = vertexSize ? header.vertexDataSize / vertexSize : 0;
+  const uint64_t dataEnd     = header.vertexDataOffset + header.storedVertexDataSize;
+  const uint32_t numChunks   = header.indexChunkCount + header.vertexChunkCount;
+
+  for (uint32_t i = 0; i != numChunks; i++) {
+    const MeshFileChunk& c = chunks[i];
+    const uint64_t limit   = i < header.indexChunkCount ? numIndices : numVertices;
+    if (c.dataOffset < header.indexDataOffset || c.dataOffset > dataEnd || c.dataSize > dataEnd - c.dataOffset || c.count > limit ||
+        c.first > limit - c.count)
+      return false;
+  }
+
+  const auto start = std::chrono::high_resolution_clock::now();
+
+  std::atomic<bool> success = true;
+
+  tf::Taskflow taskflow;
+
+  taskflow.for_each_index(0u, numChunks, 1u, [&](uint32_t i) {
+    const MeshFileChunk& c = chunks[i];
+    const uint8_t* src     = data + (c.dataOffset - dataOffset);
+    const int result       = i < header.indexChunkCount
+                                 ? meshopt_decodeIndexBuffer(indexData + c.first, c.count, sizeof(uint32_t), src, c.dataSize)
+                                 : meshopt_decodeVertexBuffer(vertexData + size_t(c.first) * vertexSize, c.count, vertexSize, src, c.dataSize);
+    if (result != 0)
+      success = false;
+  });
+
+  runTaskflow(taskflow);
+
+  const double seconds =
+      std::max(std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count(), 1e-9);
+  const double decodedSize = double(header.indexDataSize) + double(header.vertexDataSize);
+  const double storedSize  = double(header.storedIndexDataSize) + double(header.storedVertexDataSize);
+
+  printf(
+      "Decoded %u mesh data chunks: %.1f MB -> %.1f MB (compression ratio %.2f:1), %.3f s, %.2f GB/s\n", numChunks,
+      storedSize / (1024.0 * 1024.0), decodedSize / (1024.0 * 1024.0), storedSize > 0 ? decodedSize / storedSize : 0.0, seconds,
+      decodedSize / seconds / (1024.0 * 1024.0 * 1024.0));
+
+  return success;
+}
+
+static bool seekMeshFile(FILE* f, uint64_t offset)
 {
+#if defined(_WIN32)
+  return _fseeki64(f, (int64_t)offset, SEEK_SET) == 0;
+#else
+  return fseeko(f, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+// pad the file with zeros up to 'offset' and write the section there
+static void writeMeshFileSection(FILE* f, uint64_t& pos, uint64_t offset, const void* data, size_t size)
+{
+  static const uint8_t zeros[kMeshFileSectionAlignment] = {};
+
+  assert(offset >= pos && offset - pos <= kMeshFileSectionAlignment);
+
+  fwrite(zeros, 1, offset - pos, f);
+  if (size)
+    fwrite(data, 1, size, f);
+
+  pos = offset + size;
+}
+
+// combine the hashes of kMeshFileHashBlockSize blocks of a section (a single block is hashed as-is)
+static uint64_t combineBlockHashes(const std::vector<uint64_t>& blockHashes)
+{
+  return blockHashes.size() == 1 ? blockHashes[0] : hash64(blockHashes.data(), blockHashes.size() * sizeof(uint64_t));
+}
+
+// hash a section stored in memory; blocks are hashed in parallel
+static uint64_t hashMeshFileSection(const uint8_t* data, uint64_t size)
+{
+  std::vector<uint64_t> blockHashes((size + kMeshFileHashBlockSize - 1) / kMeshFileHashBlockSize);
+
+  auto hashBlock = [data, size, &blockHashes](uint32_t i) {
+    const uint64_t offset = i * kMeshFileHashBlockSize;
+    blockHashes[i]        = hash64(data + offset, (size_t)std::min(kMeshFileHashBlockSize, size - offset));
+  };
+
+  if (blockHashes.size() > 1) {
+    tf::Taskflow taskflow;
+    taskflow.for_each_index(0u, (uint32_t)blockHashes.size(), 1u, hashBlock);
+    runTaskflow(taskflow);
+  } else if (blockHashes.size() == 1) {
+    hashBlock(0);
+  }
+
+  return combineBlockHashes(blockHashes);
+}
+
+// hash everything between the header and the index data: vertex streams, meshes, boxes, spheres, LOD boxes, TOC, chunk table
+// and meshlets
+static uint64_t hashMeshFileDescriptors(const MeshFileHeader& header, const uint8_t* descriptors)
+{
+  return hashMeshFileSection(descriptors, header.indexDataOffset - sizeof(MeshFileHeader));
+}
+
+// read and verify everything between the header and the index data; section 'offset' lives at descriptors[offset - sizeof(MeshFileHeader)]
+static bool readMeshFileDescriptors(FILE* f, const MeshFileHeader& header, std::vector<uint8_t>& descriptors)
+{
+  descriptors.resize(header.indexDataOffset - sizeof(MeshFileHeader));
+
+  if (!seekMeshFile(f, sizeof(MeshFileHeader)) || fread(descriptors.data(), 1, descriptors.size(), f) != descriptors.size())
+    return false;
+
+  return hashMeshFileDescriptors(header, descriptors.data()) == header.descriptorsHash;
+}
+
+static bool readMeshFileHeader(const char* fileName, FILE* f, MeshFileHeader& header)
+{
+  std::error_code ec;
+  const uint64_t fileSize = std::filesystem::file_size(fileName, ec);
+
+  return !ec && fread(&header, 1, sizeof(header), f) == sizeof(header) && isMeshFileHeaderValid(header, fileSize);
+}
+
+bool isMeshDataValid(const char* fileName, uint64_t sourcesStamp, bool hashAllData)
+{
+  if (hashAllData) {
+    MappedFile file;
+
+    if (!file.open(fileName) || file.size() < sizeof(MeshFileHeader))
+      return false;
+
+    MeshFileHeader header;
+    memcpy(&header, file.data(), sizeof(header));
+
+    return isMeshFileHeaderValid(header, file.size()) && (!sourcesStamp || header.sourcesStamp == sourcesStamp) &&
+           hashMeshFileDescriptors(header, file.data() + sizeof(header)) == header.descriptorsHash &&
+           hashMeshFileSection(file.data() + header.indexDataOffset, header.storedIndexDataSize) == header.indexDataHash &&
+           hashMeshFileSection(file.data() + header.vertexDataOffset, header.storedVertexDataSize) == header.vertexDataHash;
+  }
+
   FILE* f = fopen(fileName, "rb");
 
   if (!f)
@@ -18,62 +304,59 @@ bool isMeshDataValid(const char* fileName)
 
   MeshFileHeader header;
 
-  if (fread(&header, 1, sizeof(header), f) != sizeof(header))
-    return false;
-
-  if (fseek(f, sizeof(Mesh) * header.meshCount, SEEK_CUR))
-    return false;
-
-  if (fseek(f, sizeof(BoundingBox) * header.meshCount, SEEK_CUR))
+  if (!readMeshFileHeader(fileName, f, header))
     return false;
 
-  if (fseek(f, header.indexDataSize, SEEK_CUR))
+  if (sourcesStamp && header.sourcesStamp != sourcesStamp)
     return false;
 
-  if (fseek(f, header.vertexDataSize, SEEK_CUR))
-    return false;
+  std::vector<uint8_t> descriptors;
 
-  return true;
+  return readMeshFileDescriptors(f, header, descriptors);
 }
 
-bool isMeshHierarchyValid(const char* fileName)
+uint64_t getMeshDataSourcesStamp(const char* fileName)
 {
   FILE* f = fopen(fileName, "rb");
 
   if (!f)
-    return false;
+    return 0;
 
   SCOPE_EXIT
   {
     fclose(f);
   };
 
-  return true;
+  MeshFileHeader header;
+
+  return readMeshFileHeader(fileName, f, header) ? header.sourcesStamp : 0;
 }
 
-bool isMeshMaterialsValid(const char* fileName)
+bool isMeshHierarchyValid(const char* fileName, uint64_t sourcesStamp)
+{
+  return isCacheFileValid(fileName, kSceneFileMagic, kSceneFileVersion, sourcesStamp);
+}
+
+bool isMeshMaterialsValid(const char* fileName, uint64_t sourcesStamp)
+{
+  return isCacheFileValid(fileName, kMaterialsFileMagic, kMaterialsFileVersion, sourcesStamp);
+}
+
+uint64_t getMeshMaterialsSourcesStamp(const char* fileName)
 {
   FILE* f = fopen(fileName, "rb");
 
   if (!f)
-    return false;
+    return 0;
 
   SCOPE_EXIT
   {
     fclose(f);
   };
 
-  uint64_t numMaterials  = 0;
-  uint64_t materialsSize = 0;
-
-  if (fread(&numMaterials, 1, sizeof(numMaterials), f) != sizeof(numMaterials))
-    return false;
-  if (fread(&materialsSize, 1, sizeof(materialsSize), f) != sizeof(materialsSize))
-    return false;
-  if (numMaterials * sizeof(Material) != materialsSize)
-    return false;
+  CacheFileHeader header;
 
-  return true;
+  return readCacheFileHeader(f, kMaterialsFileMagic, kMaterialsFileVersion, &header) ? header.sourcesStamp : 0;
 }
 
 MeshFileHeader loadMeshData(const char* meshFile, MeshData& out)
@@ -95,49 +378,398 @@ MeshFileHeader loadMeshData(const char* meshFile, MeshData& out)
 
   MeshFileHeader header;
 
-  if (fread(&header, 1, sizeof(header), f) != sizeof(header)) {
-    printf("Unable to read mesh file header.\n");
+  if (!readMeshFileHeader(meshFile, f, header)) {
+    printf("Corrupted or outdated mesh file '%s'.\n", meshFile);
     assert(false);
     exit(EXIT_FAILURE);
   }
 
-  if (fread(&out.streams, 1, sizeof(out.streams), f) != sizeof(out.streams)) {
-    printf("Unable to read vertex streams description.\n");
+  std::vector<uint8_t> descriptors;
+
+  if (!readMeshFileDescriptors(f, header, descriptors)) {
+    printf("Corrupted mesh descriptors in '%s'.\n", meshFile);
     assert(false);
     exit(EXIT_FAILURE);
   }
 
+  auto section = [&descriptors](uint64_t offset) { return descriptors.data() + (offset - sizeof(MeshFileHeader)); };
+
+  memcpy(&out.streams, section(sizeof(MeshFileHeader)), sizeof(out.streams));
+
   out.meshes.resize(header.meshCount);
-  if (fread(out.meshes.data(), sizeof(Mesh), header.meshCount, f) != header.meshCount) {
-    printf("Could not read mesh descriptors.\n");
-    assert(false);
-    exit(EXIT_FAILURE);
-  }
   out.boxes.resize(header.meshCount);
-  if (fread(out.boxes.data(), sizeof(BoundingBox), header.meshCount, f) != header.meshCount) {
-    printf("Could not read bounding boxes.\n");
-    assert(false);
-    exit(EXIT_FAILURE);
+  out.meshlets.resize(header.meshletCount);
+  memcpy(out.meshes.data(), section(header.meshesOffset), sizeof(Mesh) * header.meshCount);
+  memcpy(out.boxes.data(), section(header.boxesOffset), sizeof(BoundingBox) * header.meshCount);
+  if (header.meshletCount)
+    memcpy(out.meshlets.data(), section(header.meshletsOffset), sizeof(Meshlet) * header.meshletCount);
+  out.spheres.resize(getMeshFileBoundsCount(header));
+  out.lodBoxes.resize(getMeshFileBoundsCount(header));
+  if (!out.spheres.empty()) {
+    memcpy(out.spheres.data(), section(header.spheresOffset), sizeof(BoundingSphere) * out.spheres.size());
+    memcpy(out.lodBoxes.data(), section(header.lodBoxesOffset), sizeof(MeshLODBoxes) * out.lodBoxes.size());
   }
 
   out.indexData.resize(header.indexDataSize / sizeof(uint32_t));
   out.vertexData.resize(header.vertexDataSize);
 
-  if (fread(out.indexData.data(), 1, header.indexDataSize, f) != header.indexDataSize) {
+  if (header.flags & MeshFileFlags_Compressed) {
+    const MeshFileChunk* chunks = reinterpret_cast<const MeshFileChunk*>(section(header.chunksOffset));
+
+    // read all the encoded data at once and decode it on all cores
+    const uint64_t storedSize = header.vertexDataOffset + header.storedVertexDataSize - header.indexDataOffset;
+    std::vector<uint8_t> stored(storedSize);
+    if (!seekMeshFile(f, header.indexDataOffset) || fread(stored.data(), 1, storedSize, f) != storedSize) {
+      printf("Unable to read compressed mesh data.\n");
+      assert(false);
+      exit(EXIT_FAILURE);
+    }
+
+    if (hashMeshFileSection(stored.data(), header.storedIndexDataSize) != header.indexDataHash ||
+        hashMeshFileSection(stored.data() + (header.vertexDataOffset - header.indexDataOffset), header.storedVertexDataSize) !=
+            header.vertexDataHash ||
+        !decodeMeshFileChunks(
+            header, chunks, stored.data(), header.indexDataOffset, out.streams.getVertexSize(), out.indexData.data(),
+            out.vertexData.data())) {
+      printf("Corrupted compressed mesh data in '%s'.\n", meshFile);
+      assert(false);
+      exit(EXIT_FAILURE);
+    }
+
+    return header;
+  }
+
+  if (!seekMeshFile(f, header.indexDataOffset) || fread(out.indexData.data(), 1, header.indexDataSize, f) != header.indexDataSize) {
     printf("Unable to read index data.\n");
     assert(false);
     exit(EXIT_FAILURE);
   }
 
-  if (fread(out.vertexData.data(), 1, header.vertexDataSize, f) != header.vertexDataSize) {
+  if (!seekMeshFile(f, header.vertexDataOffset) ||
+      fread(out.vertexData.data(), 1, header.vertexDataSize, f) != header.vertexDataSize) {
     printf("Unable to read vertex data.\n");
     assert(false);
     exit(EXIT_FAILURE);
   }
 
+  if (hashMeshFileSection(reinterpret_cast<const uint8_t*>(out.indexData.data()), header.indexDataSize) != header.indexDataHash ||
+      hashMeshFileSection(out.vertexData.data(), header.vertexDataSize) != header.vertexDataHash) {
+    printf("Corrupted mesh data in '%s'.\n", meshFile);
+    assert(false);
+    exit(EXIT_FAILURE);
+  }
+
   return header;
 }
 
+MeshFileHeader loadMeshDataView(const char* meshFile, MeshDataView& out)
+{
+  if (!out.file.open(meshFile)) {
+    printf("Cannot map '%s'.\n", meshFile);
+    assert(false);
+    exit(EXIT_FAILURE);
+  }
+
+  const uint8_t* data = out.file.data();
+
+  MeshFileHeader header;
+
+  if (out.file.size() < sizeof(header) + sizeof(out.streams)) {
+    printf("Unable to read mesh file header.\n");
+    assert(false);
+    exit(EXIT_FAILURE);
+  }
+
+  memcpy(&header, data, sizeof(header));
+
+  if (!isMeshFileHeaderValid(header, out.file.size()) || hashMeshFileDescriptors(header, data + sizeof(header)) != header.descriptorsHash) {
+    printf("Corrupted or outdated mesh file '%s'.\n", meshFile);
+    assert(false);
+    exit(EXIT_FAILURE);
+  }
+
+  memcpy(&out.streams, data + sizeof(header), sizeof(out.streams));
+
+  // all sections are aligned to kMeshFileSectionAlignment, so they can be accessed in-place
+  out.header     = header;
+  out.meshes     = { reinterpret_cast<const Mesh*>(data + header.meshesOffset), header.meshCount };
+  out.boxes      = { reinterpret_cast<const BoundingBox*>(data + header.boxesOffset), header.meshCount };
+  out.toc        = { reinterpret_cast<const MeshFileTOCEntry*>(data + header.tocOffset), header.meshCount };
+  out.meshlets   = { reinterpret_cast<const Meshlet*>(data + header.meshletsOffset), header.meshletCount };
+  out.spheres    = { reinterpret_cast<const BoundingSphere*>(data + header.spheresOffset), getMeshFileBoundsCount(header) };
+  out.lodBoxes   = { reinterpret_cast<const MeshLODBoxes*>(data + header.lodBoxesOffset), getMeshFileBoundsCount(header) };
+
+  if (header.flags & MeshFileFlags_Compressed) {
+    out.decodedIndexData.resize(header.indexDataSize / sizeof(uint32_t));
+    out.decodedVertexData.resize(header.vertexDataSize);
+
+    if (!decodeMeshFileChunks(
+            header, reinterpret_cast<const MeshFileChunk*>(data + header.chunksOffset), data, 0, out.streams.getVertexSize(),
+            out.decodedIndexData.data(), out.decodedVertexData.data())) {
+      printf("Corrupted compressed mesh data in '%s'.\n", meshFile);
+      assert(false);
+      exit(EXIT_FAILURE);
+    }
+
+    out.indexData  = out.decodedIndexData;
+    out.vertexData = out.decodedVertexData;
+
+    return header;
+  }
+
+  out.indexData  = { reinterpret_cast<const uint32_t*>(data + header.indexDataOffset), header.indexDataSize / sizeof(uint32_t) };
+  out.vertexData = { data + header.vertexDataOffset, header.vertexDataSize };
+
+  return header;
+}
+
+// decode 'count' elements starting at 'first' from a byte range of the file (read into 'data' from 'dataOffset')
+static bool decodeMeshFileRange(
+    const MeshFileChunk* chunks, uint32_t chunkCount, bool isIndex, uint32_t elementSize, const std::vector<uint8_t>& data,
+    uint64_t dataOffset, uint64_t first, uint32_t count, uint8_t* dst)
+{
+  // uncompressed: the byte range holds exactly the requested elements
+  if (!chunks) {
+    if (data.size() != uint64_t(count) * elementSize)
+      return false;
+    memcpy(dst, data.data(), data.size());
+    return true;
+  }
+
+  if (!chunkCount)
+    return count == 0;
+
+  const uint64_t chunkFirst = chunks[0].first;
+  const uint64_t chunkEnd   = chunks[chunkCount - 1].first + chunks[chunkCount - 1].count;
+
+  if (first < chunkFirst || first + count > chunkEnd)
+    return false;
+
+  std::vector<uint8_t> decoded(size_t(chunkEnd - chunkFirst) * elementSize);
+
+  for (uint32_t i = 0; i != chunkCount; i++) {
+    const MeshFileChunk& c = chunks[i];
+    if (c.dataOffset < dataOffset || c.dataOffset - dataOffset + c.dataSize > data.size() || c.first < chunkFirst ||
+        c.first + c.count > chunkEnd)
+      return false;
+    const uint8_t* src = data.data() + (c.dataOffset - dataOffset);
+    uint8_t* out       = decoded.data() + size_t(c.first - chunkFirst) * elementSize;
+    const int result   = isIndex ? meshopt_decodeIndexBuffer(out, c.count, elementSize, src, c.dataSize)
+                                 : meshopt_decodeVertexBuffer(out, c.count, elementSize, src, c.dataSize);
+    if (result != 0)
+      return false;
+  }
+
+  memcpy(dst, decoded.data() + size_t(first - chunkFirst) * elementSize, size_t(count) * elementSize);
+
+  return true;
+}
+
+MeshFileHeader loadMeshSubset(const char* meshFile, const std::vector<uint32_t>& meshIds, MeshData& out)
+{
+  LVK_PROFILER_FUNCTION();
+
+  FILE* f = fopen(meshFile, "rb");
+
+  if (!f) {
+    printf("Cannot open '%s'.\n", meshFile);
+    assert(false);
+    exit(EXIT_FAILURE);
+  }
+
+  SCOPE_EXIT
+  {
+    fclose(f);
+  };
+
+  MeshFileHeader header;
+
+  if (!readMeshFileHeader(meshFile, f, header)) {
+    printf("Corrupted or outdated mesh file '%s'.\n", meshFile);
+    assert(false);
+    exit(EXIT_FAILURE);
+  }
+
+  const uint64_t fileSize = header.vertexDataOffset + header.storedVertexDataSize;
+
+  // mesh descriptors and the table of contents are small, read them all
+  std::vector<uint8_t> descriptors;
+
+  if (!readMeshFileDescriptors(f, header, descriptors)) {
+    printf("Unable to read the table of contents of '%s'.\n", meshFile);
+    assert(false);
+    exit(EXIT_FAILURE);
+  }
+
+  auto section = [&descriptors](uint64_t offset) { return descriptors.data() + (offset - sizeof(MeshFileHeader)); };
+
+  memcpy(&out.streams, section(sizeof(MeshFileHeader)), sizeof(out.streams));
+
+  const bool isCompressed   = header.flags & MeshFileFlags_Compressed;
+  const uint32_t vertexSize = out.streams.getVertexSize();
+  const uint32_t numChunks  = header.indexChunkCount + header.vertexChunkCount;
+
+  const Mesh* meshes          = reinterpret_cast<const Mesh*>(section(header.meshesOffset));
+  const BoundingBox* boxes    = reinterpret_cast<const BoundingBox*>(section(header.boxesOffset));
+  const MeshFileTOCEntry* toc = reinterpret_cast<const MeshFileTOCEntry*>(section(header.tocOffset));
+  const MeshFileChunk* chunks = reinterpret_cast<const MeshFileChunk*>(section(header.chunksOffset));
+  const Meshlet* meshlets     = reinterpret_cast<const Meshlet*>(section(header.meshletsOffset));
+  const bool hasBounds        = getMeshFileBoundsCount(header) != 0;
+  const auto* spheres         = reinterpret_cast<const BoundingSphere*>(section(header.spheresOffset));
+  const auto* lodBoxes        = reinterpret_cast<const MeshLODBoxes*>(section(header.lodBoxesOffset));
+
+  out.indexData.clear();
+  out.vertexData.clear();
+  out.meshes.clear();
+  out.boxes.clear();
+  out.meshlets.clear();
+  out.spheres.clear();
+  out.lodBoxes.clear();
+  out.meshes.reserve(meshIds.size());
+  out.boxes.reserve(meshIds.size());
+
+  // place the requested meshes into the output buffers; meshes sharing a vertex range (merged meshes) load it only once
+  std::vector<uint64_t> indexOffsets(meshIds.size());
+  std::vector<uint64_t> vertexOffsets(meshIds.size());
+  std::vector<uint32_t> vertexRanges; // mesh ids with distinct vertex ranges
+  std::vector<uint64_t> vertexRangeOffsets;
+  std::map<std::pair<uint64_t, uint32_t>, uint64_t> rangeToOffset;
+
+  uint64_t numIndices  = 0;
+  uint64_t numVertices = 0;
+
+  for (size_t i = 0; i != meshIds.size(); i++) {
+    const uint32_t id = meshIds[i];
+
+    if (id >= header.meshCount) {
+      printf("Invalid mesh id %u in '%s'.\n", id, meshFile);
+      assert(false);
+      exit(EXIT_FAILURE);
+    }
+
+    const MeshFileTOCEntry& e = toc[id];
+
+    if (e.indexDataOffset + e.indexDataSize > fileSize || e.vertexDataOffset + e.vertexDataSize > fileSize ||
+        uint64_t(e.firstIndexChunk) + e.indexChunkCount > numChunks || uint64_t(e.firstVertexChunk) + e.vertexChunkCount > numChunks) {
+      printf("Corrupted table of contents in '%s'.\n", meshFile);
+      assert(false);
+      exit(EXIT_FAILURE);
+    }
+
+    indexOffsets[i] = numIndices;
+    numIndices += e.indexCount;
+
+    const auto [it, inserted] = rangeToOffset.try_emplace({ e.firstVertex, e.vertexCount }, numVertices);
+    if (inserted) {
+      vertexRanges.push_back(id);
+      vertexRangeOffsets.push_back(numVertices);
+      numVertices += e.vertexCount;
+    }
+    vertexOffsets[i] = it->second;
+  }
+
+  out.indexData.resize(numIndices);
+  out.vertexData.resize(size_t(numVertices) * vertexSize);
+
+  // sequential reads of the stored byte ranges...
+  std::vector<std::vector<uint8_t>> indexBlobs(meshIds.size());
+  std::vector<std::vector<uint8_t>> vertexBlobs(vertexRanges.size());
+
+  uint64_t bytesRead = 0;
+
+  auto readRange = [f, meshFile, &bytesRead](uint64_t offset, uint64_t size, std::vector<uint8_t>& blob) {
+    blob.resize(size);
+    if (size && (!seekMeshFile(f, offset) || fread(blob.data(), 1, size, f) != size)) {
+      printf("Unable to read mesh data from '%s'.\n", meshFile);
+      assert(false);
+      exit(EXIT_FAILURE);
+    }
+    bytesRead += size;
+  };
+
+  for (size_t i = 0; i != meshIds.size(); i++) {
+    readRange(toc[meshIds[i]].indexDataOffset, toc[meshIds[i]].indexDataSize, indexBlobs[i]);
+  }
+  for (size_t i = 0; i != vertexRanges.size(); i++) {
+    readRange(toc[vertexRanges[i]].vertexDataOffset, toc[vertexRanges[i]].vertexDataSize, vertexBlobs[i]);
+  }
+
+  // ...and parallel decoding
+  std::atomic<bool> success = true;
+
+  tf::Taskflow taskflow;
+
+  taskflow.for_each_index(0u, uint32_t(meshIds.size() + vertexRanges.size()), 1u, [&](uint32_t i) {
+    if (i < meshIds.size()) {
+      const uint32_t id         = meshIds[i];
+      const MeshFileTOCEntry& e = toc[id];
+      uint32_t* indices         = out.indexData.data() + indexOffsets[i];
+      if (!decodeMeshFileRange(
+              isCompressed ? chunks + e.firstIndexChunk : nullptr, e.indexChunkCount, true, sizeof(uint32_t), indexBlobs[i],
+              e.indexDataOffset, e.firstIndex, e.indexCount, reinterpret_cast<uint8_t*>(indices)) ||
+          hash64(indices, size_t(e.indexCount) * sizeof(uint32_t)) != e.indexDataHash) {
+        success = false;
+        return;
+      }
+      // rebase indices to the first vertex actually used by this mesh
+      const uint32_t delta = uint32_t(meshes[id].vertexOffset - e.firstVertex);
+      for (uint32_t j = 0; j != e.indexCount; j++) {
+        indices[j] += delta;
+      }
+    } else {
+      const uint32_t r          = i - uint32_t(meshIds.size());
+      const MeshFileTOCEntry& e = toc[vertexRanges[r]];
+      uint8_t* vertices         = out.vertexData.data() + size_t(vertexRangeOffsets[r]) * vertexSize;
+      if (!decodeMeshFileRange(
+              isCompressed ? chunks + e.firstVertexChunk : nullptr, e.vertexChunkCount, false, vertexSize, vertexBlobs[r],
+              e.vertexDataOffset, e.firstVertex, e.vertexCount, vertices) ||
+          hash64(vertices, size_t(e.vertexCount) * vertexSize) != e.vertexDataHash) {
+        success = false;
+      }
+    }
+  });
+
+  runTaskflow(taskflow);
+
+  if (!success) {
+    printf("Corrupted mesh data in '%s'.\n", meshFile);
+    assert(false);
+    exit(EXIT_FAILURE);
+  }
+
+  for (size_t i = 0; i != meshIds.size(); i++) {
+    Mesh mesh         = meshes[meshIds[i]];
+    mesh.indexOffset  = indexOffsets[i];
+    mesh.vertexOffset = vertexOffsets[i];
+    // LOD offsets become relative to indexOffset
+    const uint32_t lodBase = mesh.lodOffset[0];
+    for (uint32_t l = 0; l <= mesh.lodCount; l++) {
+      mesh.lodOffset[l] -= lodBase;
+    }
+    // meshlets are relative to LOD0 of their mesh
+    if (uint64_t(mesh.firstMeshlet) + mesh.meshletCount > header.meshletCount) {
+      printf("Corrupted meshlets in '%s'.\n", meshFile);
+      assert(false);
+      exit(EXIT_FAILURE);
+    }
+    const uint32_t firstMeshlet = (uint32_t)out.meshlets.size();
+    out.meshlets.insert(out.meshlets.end(), meshlets + mesh.firstMeshlet, meshlets + mesh.firstMeshlet + mesh.meshletCount);
+    mesh.firstMeshlet = firstMeshlet;
+    out.meshes.push_back(mesh);
+    out.boxes.push_back(boxes[meshIds[i]]);
+    if (hasBounds) {
+      out.spheres.push_back(spheres[meshIds[i]]);
+      out.lodBoxes.push_back(lodBoxes[meshIds[i]]);
+    }
+  }
+
+  printf(
+      "Loaded %u of %u meshes from '%s' (%.1f MB read)\n", (uint32_t)meshIds.size(), header.meshCount, meshFile,
+      double(bytesRead) / (1024.0 * 1024.0));
+
+  return out.getMeshFileHeader();
+}
+
 void loadMeshDataMaterials(const char* fileName, MeshData& out)
 {
   FILE* f = fopen(fileName, "rb");
@@ -148,6 +780,12 @@ void loadMeshDataMaterials(const char* fileName, MeshData& out)
     exit(EXIT_FAILURE);
   }
 
+  if (!readCacheFileHeader(f, kMaterialsFileMagic, kMaterialsFileVersion)) {
+    printf("Corrupted or outdated material file '%s'.\n", fileName);
+    assert(false);
+    exit(EXIT_FAILURE);
+  }
+
   uint64_t numMaterials  = 0;
   uint64_t materialsSize = 0;
 
@@ -180,35 +818,326 @@ void loadMeshDataMaterials(const char* fileName, MeshData& out)
   fclose(f);
 }
 
-void saveMeshData(const char* fileName, const MeshData& m)
+void saveMeshData(const char* fileName, const MeshData& m, bool compress, uint64_t sourcesStamp)
 {
-  FILE* f = fopen(fileName, "wb");
+  MeshDataWriter writer(fileName, compress, sourcesStamp);
+
+  writer.addMeshData(m);
+  writer.close();
+}
+
+// pad the file with zeros up to 'offset' and copy 'size' bytes of the spooled data from 'src' there; returns the section hash
+static uint64_t copyMeshFileSection(FILE* f, uint64_t& pos, uint64_t offset, FILE* src, uint64_t size)
+{
+  writeMeshFileSection(f, pos, offset, nullptr, 0);
+
+  // one buffer is one hash block
+  std::vector<uint8_t> buffer(std::min(size, kMeshFileHashBlockSize));
+  std::vector<uint64_t> blockHashes;
+
+  if (!seekMeshFile(src, 0)) {
+    printf("Unable to read spooled mesh data.\n");
+    assert(false);
+    exit(EXIT_FAILURE);
+  }
+
+  for (uint64_t copied = 0; copied < size;) {
+    const size_t bytes = (size_t)std::min<uint64_t>(buffer.size(), size - copied);
+    if (fread(buffer.data(), 1, bytes, src) != bytes || fwrite(buffer.data(), 1, bytes, f) != bytes) {
+      printf("Unable to copy spooled mesh data.\n");
+      assert(false);
+      exit(EXIT_FAILURE);
+    }
+    blockHashes.push_back(hash64(buffer.data(), bytes));
+    copied += bytes;
+  }
+
+  pos = offset + size;
+
+  return combineBlockHashes(blockHashes);
+}
+
+static void writeSpooledMeshData(FILE* f, const void* data, size_t size)
+{
+  if (size && fwrite(data, 1, size, f) != size) {
+    printf("Unable to write spooled mesh data.\n");
+    assert(false);
+    exit(EXIT_FAILURE);
+  }
+}
+
+// compare field by field: VertexInput has padding, which is not guaranteed to match between copies
+static bool isSameVertexInput(const lvk::VertexInput& a, const lvk::VertexInput& b)
+{
+  if (a.getNumAttributes() != b.getNumAttributes() || a.getVertexSize() != b.getVertexSize())
+    return false;
+
+  for (uint32_t i = 0; i != a.getNumAttributes(); i++) {
+    const auto& aa = a.attributes[i];
+    const auto& ba = b.attributes[i];
+    if (aa.location != ba.location || aa.binding != ba.binding || aa.format != ba.format || aa.offset != ba.offset)
+      return false;
+  }
+
+  return true;
+}
+
+MeshDataWriter::MeshDataWriter(const char* fileName, bool compress, uint64_t sourcesStamp)
+: fileName_(fileName)
+, compress_(compress)
+, sourcesStamp_(sourcesStamp)
+{
+  indexFile_  = fopen((fileName_ + ".indices.tmp").c_str(), "w+b");
+  vertexFile_ = fopen((fileName_ + ".vertices.tmp").c_str(), "w+b");
+
+  if (!indexFile_ || !vertexFile_) {
+    printf("Error opening temporary files for '%s'.\n", fileName);
+    assert(false);
+    exit(EXIT_FAILURE);
+  }
+}
+
+MeshDataWriter::~MeshDataWriter()
+{
+  if (indexFile_)
+    close();
+}
+
+void MeshDataWriter::addMeshData(const MeshData& m)
+{
+  LVK_PROFILER_FUNCTION();
+
+  LVK_ASSERT(indexFile_);
+  LVK_ASSERT(m.boxes.size() == m.meshes.size());
+
+  if (!hasStreams_) {
+    streams_    = m.streams;
+    hasStreams_ = true;
+
+    const uint32_t vertexSize = streams_.getVertexSize();
+
+    // meshoptimizer vertex codec limitation
+    if (compress_ && (vertexSize == 0 || vertexSize % 4 || vertexSize > 256)) {
+      printf("Cannot compress vertex data with stride %u, saving '%s' uncompressed.\n", vertexSize, fileName_.c_str());
+      compress_ = false;
+    }
+  }
+
+  LVK_ASSERT(isSameVertexInput(streams_, m.streams));
+
+  const uint32_t vertexSize  = streams_.getVertexSize();
+  const uint64_t numVertices = vertexSize ? m.vertexData.size() / vertexSize : 0;
+
+  std::vector<MeshFileTOCEntry> toc = buildMeshFileTOC(m, vertexSize);
+
+  if (compress_) {
+    std::vector<uint64_t> indexStarts;
+    std::vector<uint64_t> vertexStarts;
+    indexStarts.reserve(toc.size());
+    vertexStarts.reserve(toc.size());
+    for (const MeshFileTOCEntry& e : toc) {
+      indexStarts.push_back(e.firstIndex);
+      vertexStarts.push_back(e.firstVertex);
+    }
+
+    // chunks start where the index and vertex ranges of meshes start, so any mesh can be decoded on its own
+    std::vector<MeshFileChunk> chunks = makeMeshFileChunks(std::move(indexStarts), m.indexData.size(), 3);
+    const uint32_t indexChunkCount    = (uint32_t)chunks.size();
+    mergeVectors(chunks, makeMeshFileChunks(std::move(vertexStarts), numVertices, 1));
+
+    std::vector<std::vector<uint8_t>> encoded(chunks.size());
+
+    tf::Taskflow taskflow;
+
+    taskflow.for_each_index(0u, (uint32_t)chunks.size(), 1u, [&](uint32_t i) {
+      const MeshFileChunk& c  = chunks[i];
+      std::vector<uint8_t>& e = encoded[i];
+      if (i < indexChunkCount) {
+        e.resize(meshopt_encodeIndexBufferBound(c.count, numVertices));
+        e.resize(meshopt_encodeIndexBuffer(e.data(), e.size(), m.indexData.data() + c.first, c.count));
+      } else {
+        e.resize(meshopt_encodeVertexBufferBound(c.count, vertexSize));
+        e.resize(meshopt_encodeVertexBuffer(e.data(), e.size(), m.vertexData.data() + c.first * vertexSize, c.count, vertexSize));
+      }
+    });
+
+    runTaskflow(taskflow);
+
+    // encoded chunks are stored back-to-back; data offsets are relative to their section until close()
+    for (uint32_t i = 0; i != chunks.size(); i++) {
+      MeshFileChunk c = chunks[i];
+      c.dataSize      = encoded[i].size();
+      if (i < indexChunkCount) {
+        writeSpooledMeshData(indexFile_, encoded[i].data(), encoded[i].size());
+        c.first += numIndices_;
+        c.dataOffset = storedIndexDataSize_;
+        storedIndexDataSize_ += c.dataSize;
+        indexChunks_.push_back(c);
+      } else {
+        writeSpooledMeshData(vertexFile_, encoded[i].data(), encoded[i].size());
+        c.first += numVertices_;
+        c.dataOffset = storedVertexDataSize_;
+        storedVertexDataSize_ += c.dataSize;
+        vertexChunks_.push_back(c);
+      }
+    }
+  } else {
+    writeSpooledMeshData(indexFile_, m.indexData.data(), m.indexData.size() * sizeof(uint32_t));
+    writeSpooledMeshData(vertexFile_, m.vertexData.data(), m.vertexData.size());
+    storedIndexDataSize_ += m.indexData.size() * sizeof(uint32_t);
+    storedVertexDataSize_ += m.vertexData.size();
+  }
+
+  // offsets of the appended meshes continue after the already written ones
+  for (size_t i = 0; i != m.meshes.size(); i++) {
+    Mesh mesh = m.meshes[i];
+    // same as getMeshIndexSize(), the TOC already knows the vertex range of the mesh
+    mesh.indexSize = toc[i].vertexCount <= 0x10000 ? sizeof(uint16_t) : sizeof(uint32_t);
+    mesh.indexOffset += numIndices_;
+    mesh.vertexOffset += numVertices_;
+    mesh.firstMeshlet += (uint32_t)meshlets_.size();
+    toc[i].firstIndex += numIndices_;
+    toc[i].firstVertex += numVertices_;
+    meshes_.push_back(mesh);
+    boxes_.push_back(m.boxes[i]);
+    toc_.push_back(toc[i]);
+  }
+
+  mergeVectors(meshlets_, m.meshlets);
+
+  // bounds are stored only if all meshes have them
+  if (!m.meshes.empty())
+    hasBounds_ = hasBounds_ && m.hasBounds();
+  if (hasBounds_) {
+    mergeVectors(spheres_, m.spheres);
+    mergeVectors(lodBoxes_, m.lodBoxes);
+  }
+
+  numIndices_ += m.indexData.size();
+  numVertices_ += numVertices;
+}
+
+MeshFileHeader MeshDataWriter::close()
+{
+  LVK_PROFILER_FUNCTION();
+
+  if (!indexFile_)
+    return header_;
+
+  const uint32_t vertexSize = streams_.getVertexSize();
+
+  MeshFileHeader& header = header_;
+
+  const uint32_t flags = (compress_ ? MeshFileFlags_Compressed : 0u) | (hasBounds_ && !meshes_.empty() ? MeshFileFlags_Bounds : 0u);
+
+  header = {
+    .meshCount            = (uint32_t)meshes_.size(),
+    .flags                = flags,
+    .indexChunkCount      = (uint32_t)indexChunks_.size(),
+    .vertexChunkCount     = (uint32_t)vertexChunks_.size(),
+    .meshletCount         = (uint32_t)meshlets_.size(),
+    .indexDataSize        = numIndices_ * sizeof(uint32_t),
+    .vertexDataSize       = numVertices_ * vertexSize,
+    .storedIndexDataSize  = storedIndexDataSize_,
+    .storedVertexDataSize = storedVertexDataSize_,
+    .sourcesStamp         = sourcesStamp_,
+  };
+
+  layoutMeshFileSections(header);
+
+  for (MeshFileChunk& c : indexChunks_) {
+    c.dataOffset += header.indexDataOffset;
+  }
+  for (MeshFileChunk& c : vertexChunks_) {
+    c.dataOffset += header.vertexDataOffset;
+  }
+
+  // byte ranges of every mesh
+  for (MeshFileTOCEntry& e : toc_) {
+    if (compress_) {
+      findMeshFileChunks(indexChunks_.data(), header.indexChunkCount, e.firstIndex, e.indexCount, e.firstIndexChunk, e.indexChunkCount);
+      findMeshFileChunks(
+          vertexChunks_.data(), header.vertexChunkCount, e.firstVertex, e.vertexCount, e.firstVertexChunk, e.vertexChunkCount);
+      if (e.indexChunkCount) {
+        const MeshFileChunk& last = indexChunks_[e.firstIndexChunk + e.indexChunkCount - 1];
+        e.indexDataOffset         = indexChunks_[e.firstIndexChunk].dataOffset;
+        e.indexDataSize           = last.dataOffset + last.dataSize - e.indexDataOffset;
+      }
+      if (e.vertexChunkCount) {
+        const MeshFileChunk& last = vertexChunks_[e.firstVertexChunk + e.vertexChunkCount - 1];
+        e.vertexDataOffset        = vertexChunks_[e.firstVertexChunk].dataOffset;
+        e.vertexDataSize          = last.dataOffset + last.dataSize - e.vertexDataOffset;
+      }
+      // chunk indices are global in the chunk table
+      e.firstVertexChunk += header.indexChunkCount;
+    } else {
+      e.indexDataOffset  = header.indexDataOffset + e.firstIndex * sizeof(uint32_t);
+      e.indexDataSize    = uint64_t(e.indexCount) * sizeof(uint32_t);
+      e.vertexDataOffset = header.vertexDataOffset + e.firstVertex * vertexSize;
+      e.vertexDataSize   = uint64_t(e.vertexCount) * vertexSize;
+    }
+  }
+
+  FILE* f = fopen(fileName_.c_str(), "wb");
 
   if (!f) {
-    printf("Error opening file '%s' for writing.\n", fileName);
+    printf("Error opening file '%s' for writing.\n", fileName_.c_str());
     assert(false);
     exit(EXIT_FAILURE);
   }
 
-  const MeshFileHeader header = {
-    .meshCount      = (uint32_t)m.meshes.size(),
-    .indexDataSize  = (uint32_t)(m.indexData.size() * sizeof(uint32_t)),
-    .vertexDataSize = (uint32_t)(m.vertexData.size()),
+  // the descriptors are assembled in memory to be hashed before writing
+  std::vector<uint8_t> descriptors(header.indexDataOffset - sizeof(header));
+
+  auto putSection = [&descriptors](uint64_t offset, const void* data, size_t size) {
+    if (size)
+      memcpy(descriptors.data() + (offset - sizeof(MeshFileHeader)), data, size);
   };
 
-  fwrite(&header, 1, sizeof(header), f);
-  fwrite(&m.streams, 1, sizeof(m.streams), f);
-  fwrite(m.meshes.data(), sizeof(Mesh), header.meshCount, f);
-  fwrite(m.boxes.data(), sizeof(BoundingBox), header.meshCount, f);
-  fwrite(m.indexData.data(), 1, header.indexDataSize, f);
-  fwrite(m.vertexData.data(), 1, header.vertexDataSize, f);
+  putSection(sizeof(header), &streams_, sizeof(streams_));
+  putSection(header.meshesOffset, meshes_.data(), sizeof(Mesh) * header.meshCount);
+  putSection(header.boxesOffset, boxes_.data(), sizeof(BoundingBox) * header.meshCount);
+  putSection(header.spheresOffset, spheres_.data(), sizeof(BoundingSphere) * getMeshFileBoundsCount(header));
+  putSection(header.lodBoxesOffset, lodBoxes_.data(), sizeof(MeshLODBoxes) * getMeshFileBoundsCount(header));
+  putSection(header.tocOffset, toc_.data(), sizeof(MeshFileTOCEntry) * header.meshCount);
+  putSection(header.chunksOffset, indexChunks_.data(), sizeof(MeshFileChunk) * indexChunks_.size());
+  putSection(
+      header.chunksOffset + sizeof(MeshFileChunk) * indexChunks_.size(), vertexChunks_.data(),
+      sizeof(MeshFileChunk) * vertexChunks_.size());
+  putSection(header.meshletsOffset, meshlets_.data(), sizeof(Meshlet) * header.meshletCount);
+
+  header.descriptorsHash = hashMeshFileDescriptors(header, descriptors.data());
+
+  uint64_t pos = 0;
+
+  writeMeshFileSection(f, pos, 0, &header, sizeof(header));
+  writeMeshFileSection(f, pos, sizeof(header), descriptors.data(), descriptors.size());
+  header.indexDataHash  = copyMeshFileSection(f, pos, header.indexDataOffset, indexFile_, header.storedIndexDataSize);
+  header.vertexDataHash = copyMeshFileSection(f, pos, header.vertexDataOffset, vertexFile_, header.storedVertexDataSize);
+
+  // the data hashes are known only now
+  if (!seekMeshFile(f, 0) || fwrite(&header, sizeof(header), 1, f) != 1) {
+    printf("Error writing file '%s'.\n", fileName_.c_str());
+    assert(false);
+    exit(EXIT_FAILURE);
+  }
 
   fclose(f);
+
+  fclose(indexFile_);
+  fclose(vertexFile_);
+  indexFile_  = nullptr;
+  vertexFile_ = nullptr;
+
+  remove((fileName_ + ".indices.tmp").c_str());
+  remove((fileName_ + ".vertices.tmp").c_str());
+
+  return header;
 }
 
-void saveMeshDataMaterials(const char* fileName, const MeshData& m)
+void saveMeshDataMaterials(const char* fileName, const MeshData& m, uint64_t sourcesStamp)
 {
-  FILE* f = fopen(fileName, "wb");
+  FILE* f = fopen(fileName, "w+b");
 
   if (!f) {
     printf("Error opening file '%s' for writing.\n", fileName);
@@ -219,12 +1148,16 @@ void saveMeshDataMaterials(const char* fileName, const MeshData& m)
   const uint64_t numMaterials  = m.materials.size();
   const uint64_t materialsSize = m.materials.size() * sizeof(Material);
 
+  beginCacheFile(f);
+
   fwrite(&numMaterials, 1, sizeof(numMaterials), f);
   fwrite(&materialsSize, 1, sizeof(materialsSize), f);
   fwrite(m.materials.data(), sizeof(Material), numMaterials, f);
 
   saveStringList(f, m.textureFiles);
 
+  finishCacheFile(f, kMaterialsFileMagic, kMaterialsFileVersion, sourcesStamp);
+
   fclose(f);
 }
 
@@ -266,77 +1199,449 @@ void loadBoundingBoxes(const char* fileName, std::vector<BoundingBox>& boxes)
 }
 
 // combine a collection of meshes into a single MeshData container
-MeshFileHeader mergeMeshData(MeshData& m, const std::vector<MeshData*> md)
+MeshFileHeader mergeMeshData(MeshData& m, const std::vector<MeshData*>& md)
 {
-  uint32_t numTotalVertices = 0;
-  uint32_t numTotalIndices  = 0;
-
-  if (!md.empty()) {
+  if (!md.empty() && m.meshes.empty()) {
     m.streams = md[0]->streams;
   }
 
   const uint32_t vertexSize = m.streams.getVertexSize();
 
-  uint32_t offset    = 0;
-  uint32_t mtlOffset = 0;
-
-  for (const MeshData* i : md) {
-    LVK_ASSERT(memcmp(&m.streams, &i->streams, sizeof(lvk::VertexInput)) == 0);
-    mergeVectors(m.indexData, i->indexData);
-    mergeVectors(m.vertexData, i->vertexData);
-    mergeVectors(m.meshes, i->meshes);
-    mergeVectors(m.boxes, i->boxes);
-
-    for (size_t j = 0; j != i->meshes.size(); j++) {
-      // m.vertexCount, m.lodCount and m.streamCount do not change
-      // m.vertexOffset also does not change, because vertex offsets are local (i.e., baked into the indices)
-      m.meshes[offset + j].indexOffset += numTotalIndices;
-      m.meshes[offset + j].materialID += mtlOffset;
-    }
+  // where every container goes in the merged arrays
+  struct Offsets {
+    size_t indices     = 0;
+    size_t vertices    = 0; // bytes
+    size_t meshes      = 0;
+    size_t boxes       = 0;
+    size_t meshlets    = 0;
+    uint32_t materials = 0;
+  };
 
-    // shift individual indices
-    for (size_t j = 0; j != i->indexData.size(); j++) {
-      m.indexData[numTotalIndices + j] += numTotalVertices;
-    }
+  std::vector<Offsets> offsets(md.size());
 
-    offset += (uint32_t)i->meshes.size();
-    mtlOffset += (uint32_t)i->materials.size();
+  Offsets total = {
+    .indices  = m.indexData.size(),
+    .vertices = m.vertexData.size(),
+    .meshes   = m.meshes.size(),
+    .boxes    = m.boxes.size(),
+    .meshlets = m.meshlets.size(),
+  };
 
-    numTotalIndices += (uint32_t)i->indexData.size();
-    numTotalVertices += (uint32_t)i->vertexData.size() / vertexSize;
+  // bounds are kept only if all the containers have them
+  bool hasBounds = m.meshes.empty() || m.hasBounds();
+
+  for (size_t i = 0; i != md.size(); i++) {
+    const MeshData* d = md[i];
+    LVK_ASSERT(isSameVertexInput(m.streams, d->streams));
+    offsets[i] = total;
+    total.indices += d->indexData.size();
+    total.vertices += d->vertexData.size();
+    total.meshes += d->meshes.size();
+    total.boxes += d->boxes.size();
+    total.meshlets += d->meshlets.size();
+    total.materials += (uint32_t)d->materials.size();
+    hasBounds = hasBounds && (d->meshes.empty() || d->hasBounds());
   }
 
+  LVK_ASSERT(total.indices <= std::numeric_limits<uint32_t>::max());
+
+  // allocate everything once, the containers are then copied in parallel into their own ranges
+  m.indexData.resize(total.indices);
+  m.vertexData.resize(total.vertices);
+  m.meshes.resize(total.meshes);
+  m.boxes.resize(total.boxes);
+  m.meshlets.resize(total.meshlets);
+  m.spheres.resize(hasBounds ? total.meshes : 0);
+  m.lodBoxes.resize(hasBounds ? total.meshes : 0);
+
+  tf::Taskflow taskflow;
+
+  for (size_t i = 0; i != md.size(); i++) {
+    const MeshData& d  = *md[i];
+    const Offsets& ofs = offsets[i];
+
+    if (!d.vertexData.empty()) {
+      taskflow.emplace([&m, &d, &ofs] { memcpy(m.vertexData.data() + ofs.vertices, d.vertexData.data(), d.vertexData.size()); });
+    }
+    if (!d.indexData.empty()) {
+      taskflow.emplace([&m, &d, &ofs] { std::copy(d.indexData.begin(), d.indexData.end(), m.indexData.begin() + ofs.indices); });
+    }
+    taskflow.emplace([&m, &d, &ofs, vertexSize, hasBounds] {
+      // indices are copied as they are, the vertices of this container are reached through the 64-bit vertex offsets of its meshes
+      const uint64_t firstVertex = vertexSize ? ofs.vertices / vertexSize : 0;
+      for (size_t j = 0; j != d.meshes.size(); j++) {
+        // vertexCount and lodCount do not change
+        Mesh& mesh = m.meshes[ofs.meshes + j];
+        mesh       = d.meshes[j];
+        mesh.indexOffset += ofs.indices;
+        mesh.vertexOffset += firstVertex;
+        mesh.materialID += ofs.materials;
+        mesh.firstMeshlet += (uint32_t)ofs.meshlets;
+      }
+      std::copy(d.boxes.begin(), d.boxes.end(), m.boxes.begin() + ofs.boxes);
+      std::copy(d.meshlets.begin(), d.meshlets.end(), m.meshlets.begin() + ofs.meshlets);
+      if (hasBounds) {
+        std::copy(d.spheres.begin(), d.spheres.end(), m.spheres.begin() + ofs.meshes);
+        std::copy(d.lodBoxes.begin(), d.lodBoxes.end(), m.lodBoxes.begin() + ofs.meshes);
+      }
+    });
+  }
+
+  runTaskflow(taskflow);
+
   return MeshFileHeader{
-    .magicValue     = 0x12345678,
-    .meshCount      = (uint32_t)offset,
-    .indexDataSize  = static_cast<uint32_t>(numTotalIndices * sizeof(uint32_t)),
-    .vertexDataSize = static_cast<uint32_t>(m.vertexData.size()),
+    .meshCount      = (uint32_t)m.meshes.size(),
+    .meshletCount   = (uint32_t)m.meshlets.size(),
+    .indexDataSize  = m.indexData.size() * sizeof(uint32_t),
+    .vertexDataSize = m.vertexData.size(),
   };
 }
 
+bool hasQuantizedPositions(const lvk::VertexInput& streams)
+{
+  return streams.attributes[0].format == lvk::VertexFormat_UShort4Norm;
+}
+
+void quantizePosition(const vec3& p, const BoundingBox& box, uint16_t out[4])
+{
+  const vec3 size = box.getSize();
+
+  for (int i = 0; i != 3; i++) {
+    const float t = size[i] > 0.0f ? glm::clamp((p[i] - box.min_[i]) / size[i], 0.0f, 1.0f) : 0.0f;
+    out[i]        = (uint16_t)(t * 65535.0f + 0.5f);
+  }
+
+  out[3] = 0;
+}
+
+vec3 dequantizePosition(const uint16_t q[4], const BoundingBox& box)
+{
+  return box.min_ + vec3(q[0], q[1], q[2]) * (1.0f / 65535.0f) * box.getSize();
+}
+
+float getPositionQuantizationBound(const BoundingBox& box)
+{
+  const vec3 size       = box.getSize();
+  const float maxExtent = std::max(size.x, std::max(size.y, size.z));
+  const vec3 maxAbs     = glm::max(glm::abs(box.min_), glm::abs(box.max_));
+  const float maxCoord  = std::max(maxAbs.x, std::max(maxAbs.y, maxAbs.z));
+
+  return 0.5f * maxExtent / 65535.0f + 4.0f * std::numeric_limits<float>::epsilon() * maxCoord;
+}
+
+static int16_t packSnorm16(float v)
+{
+  return (int16_t)std::round(glm::clamp(v, -1.0f, 1.0f) * 32767.0f);
+}
+
+// "A Survey of Efficient Representations for Independent Unit Vectors", Cigolle et al., JCGT 2014
+uint32_t encodeOctahedralNormal(const vec3& n)
+{
+  const float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+
+  if (l1 == 0.0f)
+    return 0;
+
+  vec2 p = vec2(n.x, n.y) / l1;
+
+  if (n.z < 0.0f) {
+    p = vec2((1.0f - std::abs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f), (1.0f - std::abs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f));
+  }
+
+  return uint32_t(uint16_t(packSnorm16(p.x))) | (uint32_t(uint16_t(packSnorm16(p.y))) << 16);
+}
+
+vec3 decodeOctahedralNormal(uint32_t packed)
+{
+  const vec2 p = glm::max(vec2(float(int16_t(packed & 0xFFFF)), float(int16_t(packed >> 16))) / 32767.0f, vec2(-1.0f));
+
+  vec3 n = vec3(p.x, p.y, 1.0f - std::abs(p.x) - std::abs(p.y));
+
+  if (n.z < 0.0f) {
+    n.x = (1.0f - std::abs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f);
+    n.y = (1.0f - std::abs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f);
+  }
+
+  return glm::normalize(n);
+}
+
+// box of the float3 positions of 'count' consecutive vertices, skipping the ones not marked in 'mask' (if there is a mask)
+static BoundingBox getPositionsBox(const uint8_t* vertices, uint32_t stride, uint32_t count, const uint8_t* mask)
+{
+  float outMin[4] = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+  float outMax[4] = { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+
+#if defined(VTXDATA_SIMD_SSE) || defined(VTXDATA_SIMD_NEON)
+  // 4 floats are loaded per vertex, the 4th lane (whatever follows the position) is ignored
+  if (stride >= 4 * sizeof(float)) {
+#if defined(VTXDATA_SIMD_SSE)
+    __m128 vmin = _mm_set1_ps(outMin[0]);
+    __m128 vmax = _mm_set1_ps(outMax[0]);
+    for (uint32_t i = 0; i != count; i++) {
+      if (mask && !mask[i])
+        continue;
+      const __m128 p = _mm_loadu_ps(reinterpret_cast<const float*>(vertices + size_t(i) * stride));
+      vmin           = _mm_min_ps(vmin, p);
+      vmax           = _mm_max_ps(vmax, p);
+    }
+    _mm_storeu_ps(outMin, vmin);
+    _mm_storeu_ps(outMax, vmax);
+#else
+    float32x4_t vmin = vdupq_n_f32(outMin[0]);
+    float32x4_t vmax = vdupq_n_f32(outMax[0]);
+    for (uint32_t i = 0; i != count; i++) {
+      if (mask && !mask[i])
+        continue;
+      const float32x4_t p = vld1q_f32(reinterpret_cast<const float*>(vertices + size_t(i) * stride));
+      vmin                = vminq_f32(vmin, p);
+      vmax                = vmaxq_f32(vmax, p);
+    }
+    vst1q_f32(outMin, vmin);
+    vst1q_f32(outMax, vmax);
+#endif
+    return BoundingBox(vec3(outMin[0], outMin[1], outMin[2]), vec3(outMax[0], outMax[1], outMax[2]));
+  }
+#endif
+
+  for (uint32_t i = 0; i != count; i++) {
+    if (mask && !mask[i])
+      continue;
+    float p[3];
+    memcpy(p, vertices + size_t(i) * stride, sizeof(p));
+    for (int j = 0; j != 3; j++) {
+      outMin[j] = std::min(outMin[j], p[j]);
+      outMax[j] = std::max(outMax[j], p[j]);
+    }
+  }
+
+  return BoundingBox(vec3(outMin[0], outMin[1], outMin[2]), vec3(outMax[0], outMax[1], outMax[2]));
+}
+
+void recalculateBoundingBoxes(MeshData& m, uint32_t meshIndex)
+{
+  const Mesh& mesh       = m.meshes[meshIndex];
+  const bool isQuantized = hasQuantizedPositions(m.streams);
+  const uint32_t stride  = m.streams.getVertexSize();
+
+  auto getPosition = [&m, meshIndex, isQuantized, stride](uint64_t v) -> vec3 {
+    const uint8_t* src = &m.vertexData[v * stride];
+    if (isQuantized) {
+      uint16_t q[4];
+      memcpy(q, src, sizeof(q));
+      return dequantizePosition(q, m.boxes[meshIndex]);
+    }
+    vec3 p;
+    memcpy(&p, src, sizeof(p));
+    return p;
+  };
+
+  MeshLODBoxes& lodBoxes = m.lodBoxes[meshIndex];
+
+  lodBoxes             = {};
+  m.spheres[meshIndex] = {};
+  if (!isQuantized)
+    m.boxes[meshIndex] = BoundingBox(vec3(0.0f), vec3(0.0f));
+
+  std::vector<uint8_t> mask;
+
+  for (uint32_t lod = 0; lod != std::min(mesh.lodCount, kMaxLODs); lod++) {
+    const uint32_t numIndices = mesh.getLODIndicesCount(lod);
+
+    if (!numIndices)
+      continue;
+
+    const uint32_t* indices     = m.indexData.data() + mesh.getLODFirstIndex(lod);
+    const auto [minIdx, maxIdx] = std::minmax_element(indices, indices + numIndices);
+    const uint32_t first        = *minIdx;
+    const uint32_t count        = *maxIdx - *minIdx + 1;
+    const uint64_t firstVertex  = mesh.vertexOffset + first;
+
+    // LOD0 of a converted mesh uses all its vertices; other LODs and merged meshes use a subset of their vertex range
+    const bool isMasked = lod > 0 || first != 0 || count != mesh.vertexCount;
+
+    if (isMasked) {
+      mask.assign(count, 0);
+      for (uint32_t i = 0; i != numIndices; i++) {
+        mask[indices[i] - first] = 1;
+      }
+    }
+
+    const uint8_t* vertexMask = isMasked ? mask.data() : nullptr;
+
+    BoundingBox box;
+
+    if (isQuantized) {
+      // the first vertex of the range is always referenced
+      box = BoundingBox(getPosition(firstVertex), getPosition(firstVertex));
+      for (uint32_t i = 0; i != count; i++) {
+        if (!vertexMask || vertexMask[i])
+          box.combinePoint(getPosition(firstVertex + i));
+      }
+    } else {
+      box = getPositionsBox(&m.vertexData[firstVertex * stride], stride, count, vertexMask);
+    }
+
+    lodBoxes[lod] = box;
+
+    if (lod == 0) {
+      if (!isQuantized)
+        m.boxes[meshIndex] = box;
+
+      // centered at the box: one more pass over the same vertices
+      const vec3 center = box.getCenter();
+      float radius2     = 0.0f;
+      for (uint32_t i = 0; i != count; i++) {
+        if (!vertexMask || vertexMask[i]) {
+          const vec3 d = getPosition(firstVertex + i) - center;
+          radius2      = std::max(radius2, glm::dot(d, d));
+        }
+      }
+      m.spheres[meshIndex] = { .center_ = center, .radius_ = sqrtf(radius2) };
+    }
+  }
+}
+
 void recalculateBoundingBoxes(MeshData& m)
 {
-  LVK_ASSERT(m.streams.attributes[0].format == lvk::VertexFormat_Float3);
+  LVK_PROFILER_FUNCTION();
+
+  const bool isQuantized = hasQuantizedPositions(m.streams);
+
+  if (isQuantized) {
+    LVK_ASSERT(m.boxes.size() == m.meshes.size());
+  } else {
+    LVK_ASSERT(m.streams.attributes[0].format == lvk::VertexFormat_Float3);
+    m.boxes.resize(m.meshes.size());
+  }
+
+  m.spheres.resize(m.meshes.size());
+  m.lodBoxes.resize(m.meshes.size());
+
+  tf::Taskflow taskflow;
+
+  taskflow.for_each_index(0u, (uint32_t)m.meshes.size(), 1u, [&m](uint32_t i) { recalculateBoundingBoxes(m, i); });
+
+  runTaskflow(taskflow);
+}
+
+void buildMeshlets(MeshData& m)
+{
+  LVK_PROFILER_FUNCTION();
+
+  const bool isQuantized = hasQuantizedPositions(m.streams);
+
+  LVK_ASSERT(isQuantized || m.streams.attributes[0].format == lvk::VertexFormat_Float3);
+  LVK_ASSERT(!isQuantized || m.boxes.size() == m.meshes.size());
 
   const uint32_t stride = m.streams.getVertexSize();
 
-  m.boxes.clear();
-  m.boxes.reserve(m.meshes.size());
+  std::vector<std::vector<Meshlet>> meshlets(m.meshes.size());
+
+  tf::Taskflow taskflow;
 
-  for (const Mesh& mesh : m.meshes) {
+  // meshes do not share LOD0 indices (merged meshes have their own copy), so they can be processed independently
+  taskflow.for_each_index(0u, (uint32_t)m.meshes.size(), 1u, [&](uint32_t i) {
+    const Mesh& mesh          = m.meshes[i];
     const uint32_t numIndices = mesh.getLODIndicesCount(0);
 
-    glm::vec3 vmin(std::numeric_limits<float>::max());
-    glm::vec3 vmax(std::numeric_limits<float>::lowest());
+    if (numIndices < 3)
+      return;
+
+    uint32_t* indices = m.indexData.data() + mesh.getLODFirstIndex(0);
+
+    // positions of the vertex range used by LOD0
+    const auto [minIdx, maxIdx] = std::minmax_element(indices, indices + numIndices);
+    const uint32_t firstVertex  = *minIdx;
+    const uint32_t numVertices  = *maxIdx - *minIdx + 1;
+
+    std::vector<vec3> positions(numVertices);
+    for (uint32_t v = 0; v != numVertices; v++) {
+      const uint8_t* src = &m.vertexData[(mesh.vertexOffset + firstVertex + v) * stride];
+      if (isQuantized) {
+        uint16_t q[4];
+        memcpy(q, src, sizeof(q));
+        positions[v] = dequantizePosition(q, m.boxes[i]);
+      } else {
+        memcpy(&positions[v], src, sizeof(vec3));
+      }
+    }
+
+    std::vector<uint32_t> localIndices(indices, indices + numIndices);
+    for (uint32_t& idx : localIndices) {
+      idx -= firstVertex;
+    }
+
+    const size_t maxMeshlets = meshopt_buildMeshletsBound(numIndices, kMeshletMaxVertices, kMeshletMaxTriangles);
+
+    std::vector<meshopt_Meshlet> clusters(maxMeshlets);
+    std::vector<uint32_t> clusterVertices(maxMeshlets * kMeshletMaxVertices);
+    std::vector<uint8_t> clusterTriangles(maxMeshlets * kMeshletMaxTriangles * 3);
+
+    clusters.resize(meshopt_buildMeshlets(
+        clusters.data(), clusterVertices.data(), clusterTriangles.data(), localIndices.data(), numIndices, &positions[0].x, numVertices,
+        sizeof(vec3), kMeshletMaxVertices, kMeshletMaxTriangles, 0.25f));
+
+    // rewrite LOD0 in meshlet order
+    uint32_t numWritten = 0;
+
+    std::vector<uint32_t> clusterIndices(kMeshletMaxTriangles * 3);
 
-    for (uint32_t i = 0; i != numIndices; i++) {
-      const uint32_t vtxOffset = m.indexData[mesh.indexOffset + i] + mesh.vertexOffset;
-      const float* vf          = (const float*)&m.vertexData[vtxOffset * stride];
+    meshlets[i].reserve(clusters.size());
 
-      vmin = glm::min(vmin, vec3(vf[0], vf[1], vf[2]));
-      vmax = glm::max(vmax, vec3(vf[0], vf[1], vf[2]));
+    for (const meshopt_Meshlet& c : clusters) {
+      const uint32_t* clusterVerts = clusterVertices.data() + c.vertex_offset;
+      const uint8_t* clusterTris   = clusterTriangles.data() + c.triangle_offset;
+
+      const meshopt_Bounds bounds =
+          meshopt_computeMeshletBounds(clusterVerts, clusterTris, c.triangle_count, &positions[0].x, numVertices, sizeof(vec3));
+
+      meshlets[i].push_back({
+          .center     = vec3(bounds.center[0], bounds.center[1], bounds.center[2]),
+          .radius     = bounds.radius,
+          .coneAxis   = vec3(bounds.cone_axis[0], bounds.cone_axis[1], bounds.cone_axis[2]),
+          .coneCutoff = bounds.cone_cutoff,
+          .firstIndex = numWritten,
+          .indexCount = c.triangle_count * 3,
+      });
+
+      // meshlets keep neighbouring triangles together, but not in the order optimized for the post-transform vertex cache: every
+      // meshlet is optimized again on its own (each one starts with a cold cache, so ACMR ends up slightly above the whole-mesh one)
+      const uint32_t clusterIndexCount = c.triangle_count * 3;
+      for (uint32_t j = 0; j != clusterIndexCount; j++) {
+        clusterIndices[j] = clusterTris[j];
+      }
+      meshopt_optimizeVertexCache(clusterIndices.data(), clusterIndices.data(), clusterIndexCount, c.vertex_count);
+
+      for (uint32_t j = 0; j != clusterIndexCount; j++) {
+        indices[numWritten++] = clusterVerts[clusterIndices[j]] + firstVertex;
+      }
     }
 
-    m.boxes.emplace_back(vmin, vmax);
+    LVK_ASSERT(numWritten == numIndices);
+  });
+
+  runTaskflow(taskflow);
+
+  m.meshlets.clear();
+
+  for (size_t i = 0; i != m.meshes.size(); i++) {
+    m.meshes[i].firstMeshlet = (uint32_t)m.meshlets.size();
+    m.meshes[i].meshletCount = (uint32_t)meshlets[i].size();
+    mergeVectors(m.meshlets, meshlets[i]);
   }
+
+  printf("Meshlets: %u for %u meshes\n", (uint32_t)m.meshlets.size(), (uint32_t)m.meshes.size());
+}
+
+uint32_t getMeshIndexSize(const Mesh& mesh, std::span<const uint32_t> indexData)
+{
+  const uint64_t first = std::min<uint64_t>(mesh.indexOffset, indexData.size());
+  const uint64_t count = std::min<uint64_t>(mesh.lodOffset[mesh.lodCount] - mesh.lodOffset[0], indexData.size() - first);
+
+  if (!count)
+    return sizeof(uint16_t);
+
+  const auto [minIdx, maxIdx] = std::minmax_element(indexData.begin() + first, indexData.begin() + first + count);
+
+  return *maxIdx - *minIdx <= 0xFFFF ? sizeof(uint16_t) : sizeof(uint32_t);
 }
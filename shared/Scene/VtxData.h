@@ -1,6 +1,9 @@
 #pragma once
 
+#include <array>
+#include <span>
 #include <stdint.h>
+#include <stdio.h>
 
 #include <glm/glm.hpp>
 
@@ -9,15 +12,36 @@
 
 constexpr const uint32_t kMaxLODs = 7;
 
+// Bump this every time the layout of .meshes files changes (stale cache files are then rejected and rebuilt)
+constexpr const uint32_t kMeshFileVersion = 10;
+
+// Every section in a .meshes file starts at a multiple of this value, so it can be used directly from a memory-mapped file
+constexpr const uint64_t kMeshFileSectionAlignment = 64;
+
+// Large sections are hashed in blocks of this size (in parallel when loading), see MeshFileHeader::indexDataHash
+constexpr const uint64_t kMeshFileHashBlockSize = 16 * 1024 * 1024;
+
+// Size limits of meshlets (see buildMeshlets()), as recommended by meshoptimizer
+constexpr const uint32_t kMeshletMaxVertices  = 64;
+constexpr const uint32_t kMeshletMaxTriangles = 124;
+
+// Identify the materials file (.materials) and its layout version
+constexpr const uint32_t kMaterialsFileMagic   = 0x4C54414D; // 'MATL'
+constexpr const uint32_t kMaterialsFileVersion = 1;
+
 // All offsets are relative to the beginning of the data block (excluding headers with a Mesh list)
 struct Mesh final {
   // Number of LODs in this mesh. Strictly less than MAX_LODS, last LOD offset is used as a marker only
   uint32_t lodCount = 1;
 
+  // Size of the indices on the GPU (2 or 4 bytes). Meshes referencing at most 65536 vertices are drawn from a 16-bit index buffer,
+  // with the indices rebased to the smallest index of the mesh (see getMeshIndexSize())
+  uint32_t indexSize = sizeof(uint32_t);
+
   // The total count of all previous vertices in this mesh file
-  uint32_t indexOffset = 0;
+  uint64_t indexOffset = 0;
 
-  uint32_t vertexOffset = 0;
+  uint64_t vertexOffset = 0;
 
   // Vertex count (for all LODs)
   uint32_t vertexCount = 0;
@@ -25,29 +49,141 @@ struct Mesh final {
   // Offsets to LOD indices data. The last offset is used as a marker to calculate the size
   uint32_t lodOffset[kMaxLODs + 1] = { 0 };
 
+  // Object-space geometric error of each LOD relative to LOD0, as measured by the simplifier (0 for LOD0)
+  float lodError[kMaxLODs] = { 0 };
+
   uint32_t materialID = 0;
 
+  // Range of MeshData::meshlets covering LOD0 of this mesh (none unless built with buildMeshlets())
+  uint32_t firstMeshlet = 0;
+  uint32_t meshletCount = 0;
+
+  // Explicit tail padding: meshes are written to disk and hashed as raw bytes, so no byte may be left uninitialized
+  uint32_t reserved = 0;
+
   inline uint32_t getLODIndicesCount(uint32_t lod) const { return lod < lodCount ? lodOffset[lod + 1] - lodOffset[lod] : 0; }
+  // LOD offsets are relative to the first one (which is not always 0, see mergeIndexArray())
+  inline uint64_t getLODFirstIndex(uint32_t lod) const { return indexOffset + lodOffset[lod] - lodOffset[0]; }
 
   // Any additional information, such as mesh name, can be added here...
 };
 
+enum MeshFileFlags {
+  // index and vertex data are stored as independently encoded chunks (meshopt_encodeIndexBuffer/meshopt_encodeVertexBuffer)
+  MeshFileFlags_Compressed = 0x1,
+  // bounding spheres and per-LOD boxes of all meshes are stored (see recalculateBoundingBoxes())
+  MeshFileFlags_Bounds = 0x2,
+};
+
 struct MeshFileHeader {
   // Unique 32-bit value to check integrity of the file
   uint32_t magicValue = 0x12345678;
 
+  // Layout version of the file (see kMeshFileVersion)
+  uint32_t version = kMeshFileVersion;
+
   // Number of mesh descriptors following this header
   uint32_t meshCount = 0;
 
-  // How much space index data takes in bytes
-  uint32_t indexDataSize = 0;
+  // MeshFileFlags
+  uint32_t flags = 0;
+
+  // Number of MeshFileChunk entries for the index and vertex data (compressed files only)
+  uint32_t indexChunkCount  = 0;
+  uint32_t vertexChunkCount = 0;
+
+  // Number of Meshlet entries (0 if meshlets were not built)
+  uint32_t meshletCount = 0;
+  uint32_t padding      = 0;
+
+  // How much space index data takes in bytes (decoded)
+  uint64_t indexDataSize = 0;
 
-  // How much space vertex data takes in bytes
-  uint32_t vertexDataSize = 0;
+  // How much space vertex data takes in bytes (decoded)
+  uint64_t vertexDataSize = 0;
+
+  // How much space index and vertex data take in the file (equal to the decoded sizes for uncompressed files)
+  uint64_t storedIndexDataSize  = 0;
+  uint64_t storedVertexDataSize = 0;
+
+  // Absolute offsets of the sections in the file, aligned to kMeshFileSectionAlignment
+  uint64_t meshesOffset     = 0;
+  uint64_t boxesOffset      = 0;
+  uint64_t spheresOffset    = 0;
+  uint64_t lodBoxesOffset   = 0;
+  uint64_t tocOffset        = 0;
+  uint64_t chunksOffset     = 0;
+  uint64_t meshletsOffset   = 0;
+  uint64_t indexDataOffset  = 0;
+  uint64_t vertexDataOffset = 0;
+
+  // Stamp of the source files this cache was built from (see getFilesStamp()), 0 if unknown
+  uint64_t sourcesStamp = 0;
+
+  // XXH64 hashes of the stored data: everything between this header and the index data (vertex streams, meshes, boxes,
+  // spheres, LOD boxes, TOC, chunk table and meshlets), and the stored index and vertex data (hashes of kMeshFileHashBlockSize
+  // blocks combined)
+  uint64_t descriptorsHash = 0;
+  uint64_t indexDataHash   = 0;
+  uint64_t vertexDataHash  = 0;
 
   // According to your needs, you may add additional metadata fields...
 };
 
+// An independently encoded piece of the index or vertex data in a compressed .meshes file
+struct MeshFileChunk {
+  // Absolute offset and size of the encoded data in the file
+  uint64_t dataOffset = 0;
+  uint64_t dataSize   = 0;
+
+  // Range of decoded elements (indices or vertices) covered by this chunk
+  uint64_t first = 0;
+  uint64_t count = 0;
+};
+
+// Table of contents entry (one per mesh): where the geometry of a mesh lives, so it can be loaded on its own
+struct MeshFileTOCEntry {
+  // Indices of all LODs of the mesh (LOD 'n' starts at firstIndex + lodOffset[n] - lodOffset[0]) and
+  // vertices referenced by the mesh: [vertexOffset + min index, vertexOffset + max index]
+  uint64_t firstIndex  = 0;
+  uint64_t firstVertex = 0;
+  uint32_t indexCount  = 0;
+  uint32_t vertexCount = 0;
+
+  // Absolute byte ranges in the file holding the indices and vertices (whole chunks for compressed files)
+  uint64_t indexDataOffset  = 0;
+  uint64_t indexDataSize    = 0;
+  uint64_t vertexDataOffset = 0;
+  uint64_t vertexDataSize   = 0;
+
+  // MeshFileChunk entries covering the byte ranges above (compressed files only)
+  uint32_t firstIndexChunk  = 0;
+  uint32_t indexChunkCount  = 0;
+  uint32_t firstVertexChunk = 0;
+  uint32_t vertexChunkCount = 0;
+
+  // XXH64 hashes of the decoded indices and vertices above, so a mesh loaded on its own can be verified (see loadMeshSubset())
+  uint64_t indexDataHash  = 0;
+  uint64_t vertexDataHash = 0;
+};
+
+// A cluster of up to kMeshletMaxTriangles triangles (kMeshletMaxVertices vertices) of LOD0 of a mesh. The triangles of a meshlet
+// are contiguous in the index data, so it can be drawn by a regular indexed draw command.
+struct Meshlet final {
+  // Bounding sphere
+  vec3 center  = vec3(0.0f);
+  float radius = 0.0f;
+
+  // Normal cone: all triangles are backfacing for any camera position 'p' where
+  // dot(center - p, coneAxis) >= coneCutoff * length(center - p) + radius
+  vec3 coneAxis    = vec3(0.0f);
+  float coneCutoff = 1.0f;
+
+  // Range of indices relative to the first index of LOD0 of the mesh (see Mesh::getLODFirstIndex())
+  uint32_t firstIndex = 0;
+  uint32_t indexCount = 0;
+};
+
 enum MaterialFlags {
   sMaterialFlags_CastShadow    = 0x1,
   sMaterialFlags_ReceiveShadow = 0x2,
@@ -69,38 +205,175 @@ struct Material {
   uint32_t flags       = sMaterialFlags_CastShadow | sMaterialFlags_ReceiveShadow;
 };
 
+// Bounding boxes of all LODs of a mesh (unused entries are empty)
+using MeshLODBoxes = std::array<BoundingBox, kMaxLODs>;
+
 struct MeshData {
   lvk::VertexInput streams = {};
   std::vector<uint32_t> indexData;
   std::vector<uint8_t> vertexData;
   std::vector<Mesh> meshes;
   std::vector<BoundingBox> boxes;
+  // optional, either empty or one per mesh (see recalculateBoundingBoxes())
+  std::vector<BoundingSphere> spheres;
+  std::vector<MeshLODBoxes> lodBoxes;
+  std::vector<Meshlet> meshlets;
   std::vector<Material> materials;
   std::vector<std::string> textureFiles;
   MeshFileHeader getMeshFileHeader() const
   {
     return {
-      .meshCount      = (uint32_t)meshes.size(),
-      .indexDataSize  = (uint32_t)(indexData.size() * sizeof(uint32_t)),
-      .vertexDataSize = (uint32_t)vertexData.size(),
+      .meshCount            = (uint32_t)meshes.size(),
+      .flags                = hasBounds() ? (uint32_t)MeshFileFlags_Bounds : 0u,
+      .meshletCount         = (uint32_t)meshlets.size(),
+      .indexDataSize        = indexData.size() * sizeof(uint32_t),
+      .vertexDataSize       = vertexData.size(),
+      .storedIndexDataSize  = indexData.size() * sizeof(uint32_t),
+      .storedVertexDataSize = vertexData.size(),
     };
   }
+  bool hasBounds() const { return !meshes.empty() && spheres.size() == meshes.size() && lodBoxes.size() == meshes.size(); }
 };
 
 static_assert(sizeof(BoundingBox) == sizeof(float) * 6);
+static_assert(sizeof(Mesh) == 104);
+
+// Read-only view of mesh geometry. When loaded via loadMeshDataView() all the spans point directly into
+// a memory-mapped .meshes file, so nothing is copied and the pages are faulted in on first access.
+// Compressed files cannot be accessed in-place: their index and vertex data are decoded into the view's own storage.
+struct MeshDataView final {
+  MeshFileHeader header    = {};
+  lvk::VertexInput streams = {};
+  std::span<const Mesh> meshes;
+  std::span<const BoundingBox> boxes;
+  std::span<const BoundingSphere> spheres; // empty if not stored (see MeshFileFlags_Bounds)
+  std::span<const MeshLODBoxes> lodBoxes;
+  std::span<const MeshFileTOCEntry> toc; // empty for views of MeshData
+  std::span<const Meshlet> meshlets;
+  std::span<const uint32_t> indexData;
+  std::span<const uint8_t> vertexData;
+
+  MeshDataView() = default;
+  // non-owning view of the sections of an existing MeshData
+  explicit MeshDataView(const MeshData& m)
+  : header(m.getMeshFileHeader())
+  , streams(m.streams)
+  , meshes(m.meshes)
+  , boxes(m.boxes)
+  , spheres(m.hasBounds() ? std::span<const BoundingSphere>(m.spheres) : std::span<const BoundingSphere>())
+  , lodBoxes(m.hasBounds() ? std::span<const MeshLODBoxes>(m.lodBoxes) : std::span<const MeshLODBoxes>())
+  , meshlets(m.meshlets)
+  , indexData(m.indexData)
+  , vertexData(m.vertexData)
+  {
+  }
+
+  MeshFileHeader getMeshFileHeader() const { return header; }
+
+  // keeps the mapping alive (empty for views of MeshData)
+  MappedFile file;
 
-bool isMeshDataValid(const char* fileName);
-bool isMeshMaterialsValid(const char* fileName);
-bool isMeshHierarchyValid(const char* fileName);
+  // decoded index and vertex data of compressed files (empty otherwise)
+  std::vector<uint32_t> decodedIndexData;
+  std::vector<uint8_t> decodedVertexData;
+};
+
+// Quick checks to decide whether cache files can be reused: the header, the file size and the hashes of the small sections are
+// verified, along with the sources stamp unless it is 0. Hashing the index and vertex data of a .meshes file is optional,
+// since loadMeshData() verifies them anyway (loadMeshDataView() does not, so that it does not touch all pages of the mapping).
+bool isMeshDataValid(const char* fileName, uint64_t sourcesStamp = 0, bool hashAllData = false);
+bool isMeshMaterialsValid(const char* fileName, uint64_t sourcesStamp = 0);
+bool isMeshHierarchyValid(const char* fileName, uint64_t sourcesStamp = 0);
+// sources stamp stored in a .meshes or .materials file, 0 if the file is missing or outdated
+uint64_t getMeshDataSourcesStamp(const char* fileName);
+uint64_t getMeshMaterialsSourcesStamp(const char* fileName);
 MeshFileHeader loadMeshData(const char* meshFile, MeshData& out);
+MeshFileHeader loadMeshDataView(const char* meshFile, MeshDataView& out);
+// load geometry of the selected meshes only (in the order of 'meshIds'); out.meshes[i] corresponds to meshIds[i]
+// the descriptors and the decoded indices and vertices of every loaded mesh are verified against their hashes
+MeshFileHeader loadMeshSubset(const char* meshFile, const std::vector<uint32_t>& meshIds, MeshData& out);
 void loadMeshDataMaterials(const char* meshFile, MeshData& out);
-void saveMeshData(const char* fileName, const MeshData& m);
-void saveMeshDataMaterials(const char* fileName, const MeshData& m);
+// 'compress' stores index and vertex data as per-mesh chunks encoded with meshoptimizer (decoded in parallel at load time)
+// 'sourcesStamp' is stored in the file to detect stale caches later (see getFilesStamp())
+void saveMeshData(const char* fileName, const MeshData& m, bool compress = false, uint64_t sourcesStamp = 0);
+void saveMeshDataMaterials(const char* fileName, const MeshData& m, uint64_t sourcesStamp = 0);
+
+// Writes a .meshes file incrementally: geometry is appended one MeshData at a time (e.g. one converted mesh), so the whole
+// scene never has to be resident. Index and vertex data are spooled to temporary files; close() writes the header, the
+// mesh descriptors and the table of contents, and then appends the spooled data.
+class MeshDataWriter final
+{
+public:
+  // 'compress' and 'sourcesStamp' as in saveMeshData()
+  explicit MeshDataWriter(const char* fileName, bool compress = false, uint64_t sourcesStamp = 0);
+  ~MeshDataWriter();
+
+  MeshDataWriter(const MeshDataWriter&)            = delete;
+  MeshDataWriter& operator=(const MeshDataWriter&) = delete;
+
+  // append all meshes of 'm' (materials are not written, see saveMeshDataMaterials())
+  void addMeshData(const MeshData& m);
+
+  // finalize the file; called by the destructor if needed
+  MeshFileHeader close();
+
+  uint32_t getMeshCount() const { return (uint32_t)meshes_.size(); }
+
+private:
+  std::string fileName_;
+  bool compress_            = false;
+  uint64_t sourcesStamp_    = 0;
+  bool hasStreams_          = false;
+  lvk::VertexInput streams_ = {};
+
+  // temporary files holding index and vertex data until close()
+  FILE* indexFile_  = nullptr;
+  FILE* vertexFile_ = nullptr;
 
+  uint64_t numIndices_           = 0;
+  uint64_t numVertices_          = 0;
+  uint64_t storedIndexDataSize_  = 0;
+  uint64_t storedVertexDataSize_ = 0;
+
+  std::vector<Mesh> meshes_;
+  std::vector<BoundingBox> boxes_;
+  std::vector<BoundingSphere> spheres_;
+  std::vector<MeshLODBoxes> lodBoxes_;
+  bool hasBounds_ = true; // all added MeshData had bounds
+  std::vector<Meshlet> meshlets_;
+  std::vector<MeshFileTOCEntry> toc_;
+  std::vector<MeshFileChunk> indexChunks_;
+  std::vector<MeshFileChunk> vertexChunks_;
+
+  MeshFileHeader header_ = {};
+};
+
+// Quantized vertex layout (see convertAIMesh()): 16-bit UNORM positions relative to the BoundingBox of their mesh
+// (pos = box.min_ + q * box.getSize()), half-float UVs and octahedral-encoded 16-bit SNORM normals; 16 bytes per vertex
+bool hasQuantizedPositions(const lvk::VertexInput& streams);
+void quantizePosition(const vec3& p, const BoundingBox& box, uint16_t out[4]);
+vec3 dequantizePosition(const uint16_t q[4], const BoundingBox& box);
+// Largest per-axis error of a quantized position inside 'box': half a UNORM16 step along the longest axis, plus float rounding
+// (checked by Ch08_Sample05_QuantizationCheck)
+float getPositionQuantizationBound(const BoundingBox& box);
+uint32_t encodeOctahedralNormal(const vec3& n); // 2 x SNORM16
+vec3 decodeOctahedralNormal(uint32_t packed);
+
+// Recalculate the boxes, bounding spheres and per-LOD boxes of all meshes from the vertex data (meshes are processed in parallel).
+// Every LOD scans the vertex range it references once. Quantized positions are relative to their boxes, which are kept as is.
 void recalculateBoundingBoxes(MeshData& m);
+// the same for one mesh; all the bounds arrays must already have an entry for it
+void recalculateBoundingBoxes(MeshData& m, uint32_t meshIndex);
+
+// (re)build the meshlets of LOD0 of every mesh: the LOD0 indices are reordered so that the triangles of every meshlet are contiguous,
+// and the triangles of every meshlet are reordered for the vertex cache (the overdraw order of LOD0 is not kept)
+void buildMeshlets(MeshData& m);
+
+// 2 if the indices of all LODs of the mesh span at most 65536 vertices, 4 otherwise
+uint32_t getMeshIndexSize(const Mesh& mesh, std::span<const uint32_t> indexData);
 
-// combine a list of meshes to a single mesh container
-MeshFileHeader mergeMeshData(MeshData& m, const std::vector<MeshData*> md);
+// append the meshes of all the containers to 'm' (the containers are copied in parallel, materials are merged separately)
+MeshFileHeader mergeMeshData(MeshData& m, const std::vector<MeshData*>& md);
 
 // use to write values into MeshData::vertexData
 template <typename T> inline void put(std::vector<uint8_t>& v, const T& value)
@@ -10,8 +10,21 @@
 #include <ktx.h>
 #include <ktx-software/lib/src/gl_format.h>
 
+#include <assert.h>
+#include <filesystem>
 #include <unordered_map>
 
+#include <taskflow/taskflow.hpp>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 // lvk::ShaderModuleHandle -> GLSL source code
 std::unordered_map<uint32_t, std::string> debugGLSLSourceCode;
 
@@ -202,6 +215,302 @@ lvk::Holder<lvk::TextureHandle> loadTexture(
   return texture;
 }
 
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+  if (this != &other) {
+    close();
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+#if defined(_WIN32)
+    std::swap(mapping_, other.mapping_);
+#endif
+  }
+  return *this;
+}
+
+bool MappedFile::open(const char* fileName)
+{
+  close();
+
+#if defined(_WIN32)
+  HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+
+  SCOPE_EXIT
+  {
+    // the mapping keeps its own reference to the file
+    CloseHandle(file);
+  };
+
+  LARGE_INTEGER fileSize = {};
+
+  if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    return false;
+
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+  if (!mapping)
+    return false;
+
+  const void* ptr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+  if (!ptr) {
+    CloseHandle(mapping);
+    return false;
+  }
+
+  mapping_ = mapping;
+  data_    = static_cast<const uint8_t*>(ptr);
+  size_    = static_cast<size_t>(fileSize.QuadPart);
+#else
+  const int fd = ::open(fileName, O_RDONLY);
+
+  if (fd == -1)
+    return false;
+
+  SCOPE_EXIT
+  {
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+  };
+
+  struct stat st = {};
+
+  if (fstat(fd, &st) != 0 || st.st_size == 0)
+    return false;
+
+  void* ptr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  if (ptr == MAP_FAILED)
+    return false;
+
+  data_ = static_cast<const uint8_t*>(ptr);
+  size_ = (size_t)st.st_size;
+#endif
+
+  return true;
+}
+
+void MappedFile::close()
+{
+  if (!data_)
+    return;
+
+#if defined(_WIN32)
+  UnmapViewOfFile(data_);
+  CloseHandle((HANDLE)mapping_);
+  mapping_ = nullptr;
+#else
+  munmap((void*)data_, size_);
+#endif
+
+  data_ = nullptr;
+  size_ = 0;
+}
+
+tf::Executor& getSharedExecutor()
+{
+  static tf::Executor executor;
+
+  return executor;
+}
+
+void runTaskflow(tf::Taskflow& taskflow)
+{
+  tf::Executor& executor = getSharedExecutor();
+
+  if (executor.this_worker_id() >= 0)
+    executor.corun(taskflow);
+  else
+    executor.run(taskflow).wait();
+}
+
+namespace
+{
+constexpr uint64_t kXXPrime1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t kXXPrime2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t kXXPrime3 = 0x165667B19E3779F9ull;
+constexpr uint64_t kXXPrime4 = 0x85EBCA77C2B2AE63ull;
+constexpr uint64_t kXXPrime5 = 0x27D4EB2F165667C5ull;
+
+uint64_t rotl64(uint64_t x, int r)
+{
+  return (x << r) | (x >> (64 - r));
+}
+
+uint64_t read64(const uint8_t* p)
+{
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+uint32_t read32(const uint8_t* p)
+{
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+uint64_t xxRound(uint64_t acc, uint64_t input)
+{
+  acc += input * kXXPrime2;
+  return rotl64(acc, 31) * kXXPrime1;
+}
+
+uint64_t xxMergeRound(uint64_t acc, uint64_t val)
+{
+  acc ^= xxRound(0, val);
+  return acc * kXXPrime1 + kXXPrime4;
+}
+} // namespace
+
+uint64_t hash64(const void* data, size_t size, uint64_t seed)
+{
+  const uint8_t* p   = (const uint8_t*)data;
+  const uint8_t* end = p + size;
+
+  uint64_t h = 0;
+
+  if (size >= 32) {
+    uint64_t v1 = seed + kXXPrime1 + kXXPrime2;
+    uint64_t v2 = seed + kXXPrime2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - kXXPrime1;
+    for (; p + 32 <= end; p += 32) {
+      v1 = xxRound(v1, read64(p + 0));
+      v2 = xxRound(v2, read64(p + 8));
+      v3 = xxRound(v3, read64(p + 16));
+      v4 = xxRound(v4, read64(p + 24));
+    }
+    h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+    h = xxMergeRound(h, v1);
+    h = xxMergeRound(h, v2);
+    h = xxMergeRound(h, v3);
+    h = xxMergeRound(h, v4);
+  } else {
+    h = seed + kXXPrime5;
+  }
+
+  h += (uint64_t)size;
+
+  for (; p + 8 <= end; p += 8) {
+    h ^= xxRound(0, read64(p));
+    h = rotl64(h, 27) * kXXPrime1 + kXXPrime4;
+  }
+  if (p + 4 <= end) {
+    h ^= (uint64_t)read32(p) * kXXPrime1;
+    h = rotl64(h, 23) * kXXPrime2 + kXXPrime3;
+    p += 4;
+  }
+  for (; p < end; p++) {
+    h ^= (*p) * kXXPrime5;
+    h = rotl64(h, 11) * kXXPrime1;
+  }
+
+  h ^= h >> 33;
+  h *= kXXPrime2;
+  h ^= h >> 29;
+  h *= kXXPrime3;
+  h ^= h >> 32;
+
+  return h;
+}
+
+uint64_t getFilesStamp(std::initializer_list<const char*> fileNames)
+{
+  uint64_t stamp = 0;
+
+  for (const char* fileName : fileNames) {
+    std::error_code ec;
+    const uint64_t fileSize = std::filesystem::file_size(fileName, ec);
+    const uint64_t info[]   = {
+      ec ? ~0ull : fileSize,
+      ec ? 0ull : (uint64_t)std::filesystem::last_write_time(fileName, ec).time_since_epoch().count(),
+    };
+    stamp = hash64(fileName, strlen(fileName), stamp);
+    stamp = hash64(info, sizeof(info), stamp);
+  }
+
+  return stamp;
+}
+
+void beginCacheFile(FILE* f)
+{
+  const CacheFileHeader header = {};
+  fwrite(&header, sizeof(header), 1, f);
+}
+
+void finishCacheFile(FILE* f, uint32_t magicValue, uint32_t version, uint64_t sourcesStamp)
+{
+  const uint64_t payloadSize = (uint64_t)ftell(f) - sizeof(CacheFileHeader);
+
+  std::vector<uint8_t> payload(payloadSize);
+  fseek(f, sizeof(CacheFileHeader), SEEK_SET);
+  if (payloadSize && fread(payload.data(), payloadSize, 1, f) != 1) {
+    printf("Unable to read back cache file payload\n");
+    assert(false);
+    exit(EXIT_FAILURE);
+  }
+
+  const CacheFileHeader header = {
+    .magicValue   = magicValue,
+    .version      = version,
+    .sourcesStamp = sourcesStamp,
+    .payloadSize  = payloadSize,
+    .payloadHash  = hash64(payload.data(), payloadSize),
+  };
+  fseek(f, 0, SEEK_SET);
+  fwrite(&header, sizeof(header), 1, f);
+  fseek(f, 0, SEEK_END);
+}
+
+bool readCacheFileHeader(FILE* f, uint32_t magicValue, uint32_t version, CacheFileHeader* header)
+{
+  CacheFileHeader h;
+
+  if (fread(&h, sizeof(h), 1, f) != 1 || h.magicValue != magicValue || h.version != version)
+    return false;
+
+  if (header)
+    *header = h;
+
+  return true;
+}
+
+bool isCacheFileValid(const char* fileName, uint32_t magicValue, uint32_t version, uint64_t sourcesStamp)
+{
+  FILE* f = fopen(fileName, "rb");
+
+  if (!f)
+    return false;
+
+  SCOPE_EXIT
+  {
+    fclose(f);
+  };
+
+  CacheFileHeader header;
+
+  if (!readCacheFileHeader(f, magicValue, version, &header))
+    return false;
+
+  if (sourcesStamp && header.sourcesStamp != sourcesStamp)
+    return false;
+
+  std::error_code ec;
+  if (std::filesystem::file_size(fileName, ec) != sizeof(header) + header.payloadSize || ec)
+    return false;
+
+  std::vector<uint8_t> payload(header.payloadSize);
+  if (header.payloadSize && fread(payload.data(), header.payloadSize, 1, f) != 1)
+    return false;
+
+  return hash64(payload.data(), payload.size()) == header.payloadHash;
+}
+
 void saveStringList(FILE* f, const std::vector<std::string>& lines)
 {
   uint32_t sz = (uint32_t)lines.size();
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <algorithm>
+#include <initializer_list>
 #include <memory>
+#include <stdio.h>
 #include <string.h>
 #include <string>
 #include <vector>
@@ -14,6 +16,11 @@
 #include <lvk/LVK.h>
 #include <lvk/vulkan/VulkanUtils.h>
 
+namespace tf {
+class Executor;
+class Taskflow;
+}
+
 bool endsWith(const char* s, const char* part);
 
 std::string readShaderFile(const char* fileName);
@@ -47,6 +54,63 @@ template <typename T, typename Index = int> inline void eraseSelected(std::vecto
       })));
 }
 
+// Read-only memory-mapped file (the whole file is mapped at once)
+class MappedFile final
+{
+public:
+  MappedFile() = default;
+  ~MappedFile() { close(); }
+  MappedFile(const MappedFile&)            = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  bool open(const char* fileName);
+  void close();
+
+  bool valid() const { return data_ != nullptr; }
+  const uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+  const uint8_t* data_ = nullptr;
+  size_t size_         = 0;
+#if defined(_WIN32)
+  void* mapping_ = nullptr; // HANDLE
+#endif
+};
+
+// One thread pool for all the parallel loops of the shared code: every tf::Executor spawns hardware_concurrency() threads
+tf::Executor& getSharedExecutor();
+// Run 'taskflow' on the shared executor and wait for it. When called from one of its workers (nested parallel loops, e.g.
+// from the mesh conversion tasks in convertMeshFile()), the worker keeps executing tasks while it waits, so nothing deadlocks.
+void runTaskflow(tf::Taskflow& taskflow);
+
+// 64-bit xxHash (XXH64) of a memory block
+uint64_t hash64(const void* data, size_t size, uint64_t seed = 0);
+
+// Hash of the names, sizes and modification times of the given files (missing files are hashed as such).
+// Comparing a stored stamp with a fresh one tells whether any of the source files has changed since.
+uint64_t getFilesStamp(std::initializer_list<const char*> fileNames);
+
+// Small cache files (materials, scene) start with this header, followed by the payload
+struct CacheFileHeader {
+  uint32_t magicValue   = 0;
+  uint32_t version      = 0;
+  uint64_t sourcesStamp = 0; // see getFilesStamp()
+  uint64_t payloadSize  = 0;
+  uint64_t payloadHash  = 0;
+};
+
+// Reserve space for the header; the file has to be opened with "w+b" so that finishCacheFile() can read the payload back
+void beginCacheFile(FILE* f);
+// Hash the payload written since beginCacheFile() and fill in the header
+void finishCacheFile(FILE* f, uint32_t magicValue, uint32_t version, uint64_t sourcesStamp);
+// Read the header and check its magic and version; the file is left positioned at the payload
+bool readCacheFileHeader(FILE* f, uint32_t magicValue, uint32_t version, CacheFileHeader* header = nullptr);
+// Check the header, the payload size and hash, and (if non-zero) the sources stamp
+bool isCacheFileValid(const char* fileName, uint32_t magicValue, uint32_t version, uint64_t sourcesStamp = 0);
+
 void saveStringList(FILE* f, const std::vector<std::string>& lines);
 void loadStringList(FILE* f, std::vector<std::string>& lines);
 int addUnique(std::vector<std::string>& files, const std::string& file);
@@ -7,6 +7,8 @@
 
 #include <vector>
 
+#include "shared/UtilsMathSIMD.h"
+
 using glm::mat4;
 using glm::vec2;
 using glm::vec3;
@@ -48,16 +50,8 @@ struct BoundingBox {
   }
   vec3 getSize() const { return vec3(max_[0] - min_[0], max_[1] - min_[1], max_[2] - min_[2]); }
   vec3 getCenter() const { return 0.5f * vec3(max_[0] + min_[0], max_[1] + min_[1], max_[2] + min_[2]); }
-  void transform(const glm::mat4& t)
-  {
-    vec3 corners[] = {
-      vec3(min_.x, min_.y, min_.z), vec3(min_.x, max_.y, min_.z), vec3(min_.x, min_.y, max_.z), vec3(min_.x, max_.y, max_.z),
-      vec3(max_.x, min_.y, min_.z), vec3(max_.x, max_.y, min_.z), vec3(max_.x, min_.y, max_.z), vec3(max_.x, max_.y, max_.z),
-    };
-    for (auto& v : corners)
-      v = vec3(t * vec4(v, 1.0f));
-    *this = BoundingBox(corners, 8);
-  }
+  // 't' is affine, see transformBoxAffine()
+  void transform(const glm::mat4& t) { transformBoxAffine(t, min_, max_, min_, max_); }
   BoundingBox getTransformed(const glm::mat4& t) const
   {
     BoundingBox b = *this;
@@ -71,6 +65,11 @@ struct BoundingBox {
   }
 };
 
+struct BoundingSphere {
+  vec3 center_  = vec3(0.0f);
+  float radius_ = 0.0f;
+};
+
 template <typename T> T clamp(T v, T a, T b)
 {
   if (v < a)
@@ -128,17 +127,13 @@ inline bool isBoxInFrustum(glm::vec4* frustumPlanes, glm::vec4* frustumCorners,
 {
   using glm::dot;
 
+  // all 8 corners are behind a plane when the corner farthest along its normal is (center/extent form, as in transformBoxAffine())
+  const vec3 center = box.getCenter();
+  const vec3 extent = 0.5f * box.getSize();
+
   for (int i = 0; i < 6; i++) {
-    int r = 0;
-    r += (dot(frustumPlanes[i], vec4(box.min_.x, box.min_.y, box.min_.z, 1.0f)) < 0.0) ? 1 : 0;
-    r += (dot(frustumPlanes[i], vec4(box.max_.x, box.min_.y, box.min_.z, 1.0f)) < 0.0) ? 1 : 0;
-    r += (dot(frustumPlanes[i], vec4(box.min_.x, box.max_.y, box.min_.z, 1.0f)) < 0.0) ? 1 : 0;
-    r += (dot(frustumPlanes[i], vec4(box.max_.x, box.max_.y, box.min_.z, 1.0f)) < 0.0) ? 1 : 0;
-    r += (dot(frustumPlanes[i], vec4(box.min_.x, box.min_.y, box.max_.z, 1.0f)) < 0.0) ? 1 : 0;
-    r += (dot(frustumPlanes[i], vec4(box.max_.x, box.min_.y, box.max_.z, 1.0f)) < 0.0) ? 1 : 0;
-    r += (dot(frustumPlanes[i], vec4(box.min_.x, box.max_.y, box.max_.z, 1.0f)) < 0.0) ? 1 : 0;
-    r += (dot(frustumPlanes[i], vec4(box.max_.x, box.max_.y, box.max_.z, 1.0f)) < 0.0) ? 1 : 0;
-    if (r == 8)
+    const vec3 n = vec3(frustumPlanes[i]);
+    if (dot(n, center) + dot(glm::abs(n), extent) + frustumPlanes[i].w < 0.0f)
       return false;
   }
 
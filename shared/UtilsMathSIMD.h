@@ -0,0 +1,122 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Affine transform kernels: the bottom row of all matrices is assumed to be (0, 0, 0, 1), so only their 3x4 part is used.
+// Matrices are column-major glm::mat4, which can be loaded as 4 columns without any shuffling.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UTILS_SIMD_SSE 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define UTILS_SIMD_NEON 1
+#endif
+
+#if defined(UTILS_SIMD_SSE) || defined(UTILS_SIMD_NEON)
+// 4 floats in a register
+struct SIMD4f {
+#if defined(UTILS_SIMD_SSE)
+  __m128 v;
+  static SIMD4f load(const float* p) { return { _mm_loadu_ps(p) }; }
+  static SIMD4f load(const glm::vec3& p) { return { _mm_setr_ps(p.x, p.y, p.z, 0.0f) }; }
+  static SIMD4f splat(float f) { return { _mm_set1_ps(f) }; }
+  void store(float* p) const { _mm_storeu_ps(p, v); }
+  SIMD4f operator+(SIMD4f b) const { return { _mm_add_ps(v, b.v) }; }
+  SIMD4f operator-(SIMD4f b) const { return { _mm_sub_ps(v, b.v) }; }
+  SIMD4f operator*(SIMD4f b) const { return { _mm_mul_ps(v, b.v) }; }
+  SIMD4f abs() const { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), v) }; }
+  template <int i> SIMD4f splat() const { return { _mm_shuffle_ps(v, v, _MM_SHUFFLE(i, i, i, i)) }; }
+#else
+  float32x4_t v;
+  static SIMD4f load(const float* p) { return { vld1q_f32(p) }; }
+  static SIMD4f load(const glm::vec3& p) { return { float32x4_t{ p.x, p.y, p.z, 0.0f } }; }
+  static SIMD4f splat(float f) { return { vdupq_n_f32(f) }; }
+  void store(float* p) const { vst1q_f32(p, v); }
+  SIMD4f operator+(SIMD4f b) const { return { vaddq_f32(v, b.v) }; }
+  SIMD4f operator-(SIMD4f b) const { return { vsubq_f32(v, b.v) }; }
+  SIMD4f operator*(SIMD4f b) const { return { vmulq_f32(v, b.v) }; }
+  SIMD4f abs() const { return { vabsq_f32(v) }; }
+  template <int i> SIMD4f splat() const { return { vdupq_n_f32(vgetq_lane_f32(v, i)) }; }
+#endif
+  glm::vec3 toVec3() const
+  {
+    float f[4];
+    store(f);
+    return glm::vec3(f[0], f[1], f[2]);
+  }
+};
+#endif
+
+// out = a * b
+inline void multiplyAffine(const glm::mat4& a, const glm::mat4& b, glm::mat4& out)
+{
+#if defined(UTILS_SIMD_SSE) || defined(UTILS_SIMD_NEON)
+  const SIMD4f a0 = SIMD4f::load(&a[0].x);
+  const SIMD4f a1 = SIMD4f::load(&a[1].x);
+  const SIMD4f a2 = SIMD4f::load(&a[2].x);
+  const SIMD4f a3 = SIMD4f::load(&a[3].x);
+
+  // 'b' is loaded before 'out' is written, so 'out' can be 'b'
+  SIMD4f r[4];
+  for (int i = 0; i != 4; i++) {
+    const SIMD4f c = SIMD4f::load(&b[i].x);
+    r[i]           = a0 * c.splat<0>() + a1 * c.splat<1>() + a2 * c.splat<2>();
+  }
+  r[0].store(&out[0].x);
+  r[1].store(&out[1].x);
+  r[2].store(&out[2].x);
+  (r[3] + a3).store(&out[3].x);
+#else
+  const glm::mat4 r = {
+    a[0] * b[0].x + a[1] * b[0].y + a[2] * b[0].z,
+    a[0] * b[1].x + a[1] * b[1].y + a[2] * b[1].z,
+    a[0] * b[2].x + a[1] * b[2].y + a[2] * b[2].z,
+    a[0] * b[3].x + a[1] * b[3].y + a[2] * b[3].z + a[3],
+  };
+  out = r;
+#endif
+}
+
+inline glm::vec3 transformPointAffine(const glm::mat4& t, const glm::vec3& p)
+{
+#if defined(UTILS_SIMD_SSE) || defined(UTILS_SIMD_NEON)
+  return (SIMD4f::load(&t[0].x) * SIMD4f::splat(p.x) + SIMD4f::load(&t[1].x) * SIMD4f::splat(p.y) +
+          SIMD4f::load(&t[2].x) * SIMD4f::splat(p.z) + SIMD4f::load(&t[3].x))
+      .toVec3();
+#else
+  return glm::vec3(t[0]) * p.x + glm::vec3(t[1]) * p.y + glm::vec3(t[2]) * p.z + glm::vec3(t[3]);
+#endif
+}
+
+// Transform an axis-aligned box and return the box around the result (J. Arvo, "Transforming Axis-Aligned Bounding Boxes",
+// Graphics Gems, 1990): the center is transformed as a point and the half-extent by the absolute values of the 3x3 part,
+// which gives the same box as transforming all 8 corners.
+inline void transformBoxAffine(const glm::mat4& t, const glm::vec3& min, const glm::vec3& max, glm::vec3& outMin, glm::vec3& outMax)
+{
+#if defined(UTILS_SIMD_SSE) || defined(UTILS_SIMD_NEON)
+  const SIMD4f half   = SIMD4f::splat(0.5f);
+  const SIMD4f bmin   = SIMD4f::load(min);
+  const SIMD4f bmax   = SIMD4f::load(max);
+  const SIMD4f center = (bmax + bmin) * half;
+  const SIMD4f extent = (bmax - bmin) * half;
+
+  const SIMD4f t0 = SIMD4f::load(&t[0].x);
+  const SIMD4f t1 = SIMD4f::load(&t[1].x);
+  const SIMD4f t2 = SIMD4f::load(&t[2].x);
+
+  const SIMD4f c = t0 * center.splat<0>() + t1 * center.splat<1>() + t2 * center.splat<2>() + SIMD4f::load(&t[3].x);
+  const SIMD4f e = t0.abs() * extent.splat<0>() + t1.abs() * extent.splat<1>() + t2.abs() * extent.splat<2>();
+
+  outMin = (c - e).toVec3();
+  outMax = (c + e).toVec3();
+#else
+  const glm::vec3 center = 0.5f * (max + min);
+  const glm::vec3 extent = 0.5f * (max - min);
+  const glm::vec3 c      = glm::vec3(t[0]) * center.x + glm::vec3(t[1]) * center.y + glm::vec3(t[2]) * center.z + glm::vec3(t[3]);
+  const glm::vec3 e =
+      glm::abs(glm::vec3(t[0])) * extent.x + glm::abs(glm::vec3(t[1])) * extent.y + glm::abs(glm::vec3(t[2])) * extent.z;
+  outMin = c - e;
+  outMax = c + e;
+#endif
+}